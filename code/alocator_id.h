@@ -0,0 +1,44 @@
+#ifndef ALOCATOR_ID_H
+#define ALOCATOR_ID_H
+
+#include <atomic>
+
+// Hands out unique 64-bit ids from any number of threads, without locks.
+// With a single global counter every constructor on every thread would fight
+// over the same atomic, so instead each thread reserves a block of MARIME_BLOC
+// ids from it and hands them out by itself. The shared counter is touched
+// once per block.
+// On one thread the ids are still 1, 2, 3, ...; with several threads each one
+// works in its own ranges, so the ids are unique but not in creation order.
+//
+// 'Familie' only keeps the counters apart: AlocatorId<Calculator> and
+// AlocatorId<void> count independently. It's a utility class, only static methods.
+template <typename Familie>
+class AlocatorId {
+private:
+    AlocatorId() = delete;
+
+    static const long long MARIME_BLOC = 1024;
+
+    struct Bloc {
+        long long urmator;
+        long long sfarsit;
+    };
+
+    static std::atomic<long long> urmatorul;        // first id not reserved by any thread
+
+public:
+    static long long aloca() {
+        thread_local Bloc bloc = {0, 0};
+        if (bloc.urmator == bloc.sfarsit) {
+            bloc.urmator = urmatorul.fetch_add(MARIME_BLOC, std::memory_order_relaxed);
+            bloc.sfarsit = bloc.urmator + MARIME_BLOC;
+        }
+        return bloc.urmator++;
+    }
+};
+
+template <typename Familie>
+std::atomic<long long> AlocatorId<Familie>::urmatorul(1);
+
+#endif
@@ -3,6 +3,22 @@
 #include <typeinfo>
 #include <cstring>
 #include <algorithm>
+#include <map>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <atomic>
+#include <climits>
+#include <fstream>
+#include <string>
+#include <charconv>
+#include <chrono>
+#include <set>
+#include <unordered_map>
+#include <queue>
+#include <numeric>
+#include <typeindex>
+#include <utility>
 using namespace std;
 
 class InsufficientPointsException : public std::exception{
@@ -19,16 +35,383 @@ class InvalidIdException : public std::exception{
         }
     };
 
+class InvalidSnapshotException : public std::exception{
+    public:
+        virtual const char* what() const throw(){
+            return "snapshot invalid";
+        }
+    };
+
+class PointsOverflowException : public std::exception{
+    public:
+        virtual const char* what() const throw(){
+            return "depasire puncte";
+        }
+    };
+
+class InvalidJournalException : public std::exception{
+    public:
+        virtual const char* what() const throw(){
+            return "jurnal invalid";
+        }
+    };
+
+class UpgradeOverflowException : public std::exception{
+    public:
+        virtual const char* what() const throw(){
+            return "depasire upgrade-uri";
+        }
+    };
+
+// Rezultatul variantelor try* din Inventar, fara exceptii pe calea de eroare
+enum CodRezultat{
+    OK,
+    PUNCTE_INSUFICIENTE,
+    ID_INVALID,
+    DEPASIRE_PUNCTE
+};
+
+// Transforma un cod de eroare in exceptia corespunzatoare
+void verificaRezultat(CodRezultat cod) {
+    switch (cod) {
+        case OK: return;
+        case PUNCTE_INSUFICIENTE: throw InsufficientPointsException();
+        case ID_INVALID: throw InvalidIdException();
+        case DEPASIRE_PUNCTE: throw PointsOverflowException();
+    }
+}
+
+// Pune INVENTAR_METRICI pe 0 (de ex. -DINVENTAR_METRICI=0) ca macro-urile
+// METRICA_* sa nu mai genereze niciun cod.
+#ifndef INVENTAR_METRICI
+#define INVENTAR_METRICI 1
+#endif
+
+enum OperatieMetrica{
+    OP_ADAUGA,
+    OP_UPGRADE,
+    OP_VINDE,
+    OP_CAUTARE,
+    OP_SORTARE,
+    NR_OPERATII
+};
+
+const char* const NUME_OPERATII[NR_OPERATII] = {"adauga", "upgrade", "vinde", "cautare", "sortare"};
+
+// Contoare si histograme de latenta. Fiecare thread scrie doar in blocul lui
+// (fara operatii atomice read-modify-write), iar blocurile se aduna la citire.
+class Metrici{
+public:
+    // bucket-ul b numara latentele <= 2^b ns; ultimul ia tot ce e mai mare
+    static const int NR_BUCKETI = 32;
+private:
+    struct Bloc{
+        atomic<long long> operatii[NR_OPERATII];
+        atomic<long long> sumaNs[NR_OPERATII];
+        atomic<long long> histograma[NR_OPERATII][NR_BUCKETI];
+        atomic<long long> puncteCheltuite;
+        atomic<long long> puncteCastigate;
+
+        Bloc():puncteCheltuite(0),puncteCastigate(0) {
+            for(int op = 0 ; op < NR_OPERATII ; op++) {
+                operatii[op] = 0;
+                sumaNs[op] = 0;
+                for(int b = 0 ; b < NR_BUCKETI ; b++)
+                    histograma[op][b] = 0;
+            }
+        }
+
+        // Doar sub lock-ul din Metrici, deci tot un singur thread scrie
+        void aduna(const Bloc& alt) {
+            for(int op = 0 ; op < NR_OPERATII ; op++) {
+                adauga(operatii[op], alt.operatii[op].load(memory_order_relaxed));
+                adauga(sumaNs[op], alt.sumaNs[op].load(memory_order_relaxed));
+                for(int b = 0 ; b < NR_BUCKETI ; b++)
+                    adauga(histograma[op][b], alt.histograma[op][b].load(memory_order_relaxed));
+            }
+            adauga(puncteCheltuite, alt.puncteCheltuite.load(memory_order_relaxed));
+            adauga(puncteCastigate, alt.puncteCastigate.load(memory_order_relaxed));
+        }
+    };
+
+    // Sterge blocul thread-ului cand thread-ul se termina
+    struct DetinatorBloc{
+        Metrici* metrici;
+        Bloc* bloc;
+        ~DetinatorBloc(){
+            if (bloc != nullptr)
+                metrici->retrage(bloc);
+        }
+    };
+
+    // Blocurile thread-urilor care ruleaza, plus `terminate`, in care e adunat
+    // blocul unui thread cand se termina, ca valorile lui sa ramana in totaluri
+    mutable mutex mtx;
+    Bloc terminate;
+    vector<Bloc*> blocuri;
+
+    Metrici(){ blocuri.push_back(&terminate); }
+    Metrici(const Metrici&);
+    void operator=(const Metrici&);
+
+    // Un singur thread scrie in bloc, deci load + store ajunge
+    static void adauga(atomic<long long>& contor, long long valoare) {
+        contor.store(contor.load(memory_order_relaxed) + valoare, memory_order_relaxed);
+    }
+
+    Bloc& bloculMeu() {
+        thread_local DetinatorBloc detinator = {nullptr, nullptr};
+        if (detinator.bloc == nullptr) {
+            detinator.metrici = this;
+            detinator.bloc = new Bloc();
+            lock_guard<mutex> blocare(mtx);
+            blocuri.push_back(detinator.bloc);
+        }
+        return *detinator.bloc;
+    }
+
+    void retrage(Bloc* bloc) {
+        lock_guard<mutex> blocare(mtx);
+        terminate.aduna(*bloc);
+        blocuri.erase(find(blocuri.begin(), blocuri.end(), bloc));
+        delete bloc;
+    }
+
+    long long suma(atomic<long long> Bloc::*contor) const;
+public:
+    ~Metrici(){
+        for(int i = 0 ; i < blocuri.size() ; i++)
+            if (blocuri[i] != &terminate)
+                delete blocuri[i];
+    }
+
+    static Metrici& getInstance() {
+        static Metrici instance;
+        return instance;
+    }
+
+    void operatie(OperatieMetrica op, long long ns) {
+        Bloc& bloc = bloculMeu();
+        int bucket = 0;
+        while (bucket < NR_BUCKETI - 1 && (1LL << bucket) < ns)
+            bucket++;
+        adauga(bloc.operatii[op], 1);
+        adauga(bloc.sumaNs[op], ns);
+        adauga(bloc.histograma[op][bucket], 1);
+    }
+    void puncteCheltuite(long long puncte) { adauga(bloculMeu().puncteCheltuite, puncte); }
+    void puncteCastigate(long long puncte) { adauga(bloculMeu().puncteCastigate, puncte); }
+
+    // Format text Prometheus
+    void scrie(ostream& out) const;
+};
+
+long long Metrici::suma(atomic<long long> Bloc::*contor) const {
+    long long total = 0;
+    for(int i = 0 ; i < blocuri.size() ; i++)
+        total += (blocuri[i]->*contor).load(memory_order_relaxed);
+    return total;
+}
+
+void Metrici::scrie(ostream& out) const {
+    lock_guard<mutex> blocare(mtx);
+
+    out << "# TYPE inventar_latenta_ns histogram\n";
+    for(int op = 0 ; op < NR_OPERATII ; op++) {
+        long long cumulat = 0, numar = 0, sumaNs = 0;
+        for(int i = 0 ; i < blocuri.size() ; i++) {
+            numar += blocuri[i]->operatii[op].load(memory_order_relaxed);
+            sumaNs += blocuri[i]->sumaNs[op].load(memory_order_relaxed);
+        }
+        for(int b = 0 ; b < NR_BUCKETI - 1 ; b++) {
+            for(int i = 0 ; i < blocuri.size() ; i++)
+                cumulat += blocuri[i]->histograma[op][b].load(memory_order_relaxed);
+            out << "inventar_latenta_ns_bucket{op=\"" << NUME_OPERATII[op] << "\",le=\"" << (1LL << b) << "\"} " << cumulat << '\n';
+        }
+        out << "inventar_latenta_ns_bucket{op=\"" << NUME_OPERATII[op] << "\",le=\"+Inf\"} " << numar << '\n';
+        out << "inventar_latenta_ns_sum{op=\"" << NUME_OPERATII[op] << "\"} " << sumaNs << '\n';
+        out << "inventar_latenta_ns_count{op=\"" << NUME_OPERATII[op] << "\"} " << numar << '\n';
+    }
+
+    out << "# TYPE inventar_puncte_cheltuite_total counter\n";
+    out << "inventar_puncte_cheltuite_total " << suma(&Bloc::puncteCheltuite) << '\n';
+    out << "# TYPE inventar_puncte_castigate_total counter\n";
+    out << "inventar_puncte_castigate_total " << suma(&Bloc::puncteCastigate) << '\n';
+}
+
+// Masoara durata blocului curent si o adauga la metricile operatiei
+class CronometruMetrica{
+private:
+    OperatieMetrica op;
+    chrono::steady_clock::time_point start;
+public:
+    CronometruMetrica(OperatieMetrica op):op(op),start(chrono::steady_clock::now()){}
+    ~CronometruMetrica(){
+        Metrici::getInstance().operatie(op, chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count());
+    }
+};
+
+#if INVENTAR_METRICI
+#define METRICA_OPERATIE(op) CronometruMetrica cronometruMetrica(op)
+#define METRICA_PUNCTE_CHELTUITE(puncte) Metrici::getInstance().puncteCheltuite(puncte)
+#define METRICA_PUNCTE_CASTIGATE(puncte) Metrici::getInstance().puncteCastigate(puncte)
+#else
+#define METRICA_OPERATIE(op)
+#define METRICA_PUNCTE_CHELTUITE(puncte)
+#define METRICA_PUNCTE_CASTIGATE(puncte)
+#endif
+
+// Soldul de puncte al inventarului. Toate operatiile sunt compare-and-swap
+// pe un singur atomic, asa ca verificarea si modificarea soldului se fac
+// intr-un singur pas, fara alt lock. Inventarul cheltuie totusi sub lock-ul
+// lui, pentru ca si costul depinde de item-uri; ce castiga de aici e ca
+// getPuncte() citeste soldul fara sa astepte dupa lock.
+class RegistruPuncte{
+public:
+    struct Tranzactie{
+        long long suma;     // negativ pentru cheltuieli
+        int soldDupa;
+    };
+private:
+    atomic<int> sold;
+
+    // Jurnal optional, doar adaugare; are lock-ul lui
+    atomic<bool> jurnalActiv;
+    mutable mutex mtxJurnal;
+    vector<Tranzactie> jurnal;
+
+    void inregistreaza(long long suma, int soldDupa);
+public:
+    RegistruPuncte(int soldInitial):sold(soldInitial),jurnalActiv(false){}
+
+    int getSold() const { return sold.load(); }
+    void seteazaSold(int valoare) { sold = valoare; }
+    vector<Tranzactie> getJurnal() const;
+    void activeazaJurnal(bool activ) { jurnalActiv = activ; }
+
+    bool incearcaCheltuie(long long cost);
+    bool incearcaCrediteaza(long long suma);
+    void crediteaza(long long suma);
+};
+
+void RegistruPuncte::inregistreaza(long long suma, int soldDupa) {
+    if (!jurnalActiv)
+        return;
+    lock_guard<mutex> blocare(mtxJurnal);
+    Tranzactie t = {suma, soldDupa};
+    jurnal.push_back(t);
+}
+
+vector<RegistruPuncte::Tranzactie> RegistruPuncte::getJurnal() const {
+    lock_guard<mutex> blocare(mtxJurnal);
+    return jurnal;
+}
+
+bool RegistruPuncte::incearcaCheltuie(long long cost) {
+    if (cost < 0)
+        return false;
+    int vechi = sold.load();
+    do {
+        if (vechi < cost)
+            return false;
+    } while (!sold.compare_exchange_weak(vechi, vechi - cost));
+    inregistreaza(-cost, vechi - cost);
+    METRICA_PUNCTE_CHELTUITE(cost);
+    return true;
+}
+
+bool RegistruPuncte::incearcaCrediteaza(long long suma) {
+    int vechi = sold.load();
+    do {
+        if (suma < 0 || suma > INT_MAX - vechi)
+            return false;
+    } while (!sold.compare_exchange_weak(vechi, vechi + suma));
+    inregistreaza(suma, vechi + suma);
+    METRICA_PUNCTE_CASTIGATE(suma);
+    return true;
+}
+
+void RegistruPuncte::crediteaza(long long suma) {
+    if (!incearcaCrediteaza(suma))
+        throw PointsOverflowException();
+}
+
+enum TipItem{
+    ZID,
+    TURN,
+    ROBOT_AERIAN,
+    ROBOT_TERESTRU,
+    NR_TIPURI
+};
+
+const char* const NUME_TIPURI[NR_TIPURI] = {"Zid", "Turn", "RobotAerian", "RobotTerestru"};
+
+// Costurile de upgrade sunt intregi pe 64 de biti. Un cost care nu mai
+// incape e saturat la COST_SATURAT in loc sa dea peste cap; nu poate fi
+// platit niciodata, deci upgrade-ul respectiv e refuzat ca prea scump.
+typedef long long Cost;
+const Cost COST_SATURAT = LLONG_MAX;
+
+// Operatii pe costuri nenegative care se opresc la COST_SATURAT
+constexpr Cost adunaSaturat(Cost a, Cost b) {
+    return a > COST_SATURAT - b ? COST_SATURAT : a + b;
+}
+constexpr Cost inmultesteSaturat(Cost a, Cost b) {
+    return a != 0 && b > COST_SATURAT / a ? COST_SATURAT : a * b;
+}
+// C(m, k), saturat. Fiecare pas inmulteste cu (m - i + 1) / i, simplificand
+// intai cu i, ca produsul sa nu se satureze cand rezultatul inca incape.
+constexpr Cost combinariSaturat(Cost m, int k) {
+    Cost c = 1;
+    for(int i = 1 ; i <= k && c != COST_SATURAT ; i++) {
+        Cost d = gcd(c, (Cost)i);
+        c = inmultesteSaturat(c / d, (m - i + 1) / (i / d));
+    }
+    return c;
+}
+
+// Parcurge campurile unui item in aceeasi ordine pentru orice implementare,
+// de ex. scrierea si citirea snapshot-ului binar sau exportul text.
+// Numele campurilor sunt etichetele afisate de print.
+class VizitatorCampuri{
+public:
+    virtual ~VizitatorCampuri(){}
+    virtual void camp(const char* nume, int& valoare) = 0;
+    virtual void camp(const char* nume, double& valoare) = 0;
+    virtual void camp(const char* nume, bool& valoare) = 0;
+};
+
+// Id-ul unui item refacut dintr-un snapshot, nu unul nou dat de inventar
+struct IdRestaurat{
+    int valoare;
+    explicit IdRestaurat(int valoare):valoare(valoare){}
+};
+
 class Item{
+    friend class Inventar;
 protected:
-    const int id;
-    static int counterId;
+    // 0 pana cand item-ul e adaugat in inventar, care ii da urmatorul id
+    int id;
+    const unsigned char tip;
+
+    // Cate upgrade-uri a primit item-ul; impreuna cu tipul determina costul
+    int upgradeuri;
+
+    // Costul de upgrade e calculat o data si refolosit pana la urmatorul upgrade
+    mutable Cost costUpgradeCache;
+    mutable bool costUpgradeValid;
+
+    // Modifica campurile ca `nivele` upgrade-uri consecutive, in forma inchisa
+    virtual void aplicaUpgrade(int nivele) = 0;
 public:
-    Item():id(counterId++){}
+    Item(TipItem tip):id(0),tip(tip),upgradeuri(0),costUpgradeValid(false){}
+    Item(TipItem tip, IdRestaurat id):id(id.valoare),tip(tip),upgradeuri(0),costUpgradeValid(false){}
     virtual ~Item(){}
 
     // Getters
     int getId() const { return id; }
+    TipItem getTip() const { return (TipItem)tip; }
+    int getUpgradeuri() const { return upgradeuri; }
 
     virtual void print(ostream& os) const {
         os << "Item ID: " << this->id;
@@ -39,20 +422,278 @@ public:
         return os;
     }
 
+    virtual void viziteazaCampuri(VizitatorCampuri& v) {}
+
     virtual const int getInitialCost() const = 0;
-    virtual const int getCostUpgrade() const = 0;
-    virtual void upgrade() = 0;
+    virtual const Cost getCostUpgrade() const = 0;
+    // Costul upgrade-ului de dupa inca `upgradeuri` upgrade-uri, in forma
+    // inchisa, fara sa modificam obiectul. getCostUpgradeDupa(0) == getCostUpgrade()
+    virtual const Cost getCostUpgradeDupa(int upgradeuri) const = 0;
+    // Costul total al urmatoarelor `nivele` upgrade-uri
+    virtual const Cost getCostUpgradeuri(int nivele) const = 0;
+
+private:
+    // Doar prin Inventar, ca upgrade-ul sa fie platit si costurile tinute
+    // de inventar (coloana costuri, ordineCost) sa fie actualizate
+    Cost getCostUpgradeCached() const {
+        if (!costUpgradeValid) {
+            costUpgradeCache = getCostUpgrade();
+            costUpgradeValid = true;
+        }
+        return costUpgradeCache;
+    }
+
+    void upgrade(int nivele = 1) {
+        if (nivele < 0 || nivele > INT_MAX - upgradeuri)
+            throw UpgradeOverflowException();
+        aplicaUpgrade(nivele);
+        upgradeuri += nivele;
+        costUpgradeValid = false;
+    }
+};
+
+// Catalogul item-urilor: pentru fiecare tip concret, costurile, valorile
+// initiale si pasul de upgrade sunt declarate o singura data, aici.
+// costUpgrade(n) e costul upgrade-ului cand item-ul are deja n upgrade-uri.
+template <typename T>
+struct CatalogItem;
+
+class Zid;
+class Turn;
+class RobotAerian;
+class RobotTerestru;
+
+template <>
+struct CatalogItem<Zid>{
+    static constexpr TipItem TIP = ZID;
+    static constexpr int COST_INITIAL = 300;
+    static constexpr double LUNGIME = 1, INALTIME = 2, GROSIME = 0.5;
+    static constexpr double PAS = 1;
+    // Dimensiunile si pasul sunt multipli de 1 / SUBUNITATI, deci numarate
+    // in subunitati sunt intregi
+    static constexpr int SUBUNITATI = 2;
+    static constexpr Cost inSubunitati(double dimensiune, int n) {
+        return (Cost)(dimensiune * SUBUNITATI) + (Cost)(PAS * SUBUNITATI) * n;
+    }
+    // 100 * lungime * inaltime * grosime, calculat pe intregi ca sa nu
+    // pierdem precizie: produsul dimensiunilor in subunitati impartit la
+    // SUBUNITATI^3. Simplificam cu numitorul inainte de fiecare inmultire,
+    // ca produsul sa nu se satureze cand costul inca incape.
+    static constexpr Cost costUpgrade(int n) {
+        const Cost dimensiuni[3] = {inSubunitati(LUNGIME, n), inSubunitati(INALTIME, n), inSubunitati(GROSIME, n)};
+        Cost cost = 100, numitor = (Cost)SUBUNITATI * SUBUNITATI * SUBUNITATI;
+        for(int i = 0 ; i < 3 && cost != COST_SATURAT ; i++) {
+            Cost d = gcd(cost, numitor);
+            cost /= d;
+            numitor /= d;
+            d = gcd(dimensiuni[i], numitor);
+            cost = inmultesteSaturat(cost, dimensiuni[i] / d);
+            numitor /= d;
+        }
+        return cost == COST_SATURAT ? cost : cost / numitor;
+    }
+    // Formula pe intregi trebuie sa dea exact formula cu double a campurilor
+    static constexpr bool corespundeCampurilor(int nivele) {
+        if (inSubunitati(LUNGIME, 0) != LUNGIME * SUBUNITATI || inSubunitati(INALTIME, 0) != INALTIME * SUBUNITATI ||
+            inSubunitati(GROSIME, 0) != GROSIME * SUBUNITATI || inSubunitati(0, 1) != PAS * SUBUNITATI)
+            return false;
+        for(int n = 0 ; n < nivele ; n++)
+            if (costUpgrade(n) != (Cost)(100 * (LUNGIME + PAS * n) * (INALTIME + PAS * n) * (GROSIME + PAS * n)))
+                return false;
+        return true;
+    }
+};
+static_assert(CatalogItem<Zid>::corespundeCampurilor(1000),
+              "formula pe intregi nu mai corespunde dimensiunilor zidului");
+
+template <>
+struct CatalogItem<Turn>{
+    static constexpr TipItem TIP = TURN;
+    static constexpr int COST_INITIAL = 500;
+    static constexpr double PUTERE_LASER = 1000;
+    static constexpr double PAS_PUTERE_LASER = 500;
+    static constexpr Cost costUpgrade(int n) {
+        return inmultesteSaturat(500, (Cost)PUTERE_LASER + (Cost)PAS_PUTERE_LASER * n);
+    }
+};
+
+// Valorile comune tuturor robotilor
+struct CatalogRobot{
+    static constexpr int DAMAGE = 100, NIVEL = 1, VIATA = 100;
+};
+
+template <>
+struct CatalogItem<RobotAerian>{
+    static constexpr TipItem TIP = ROBOT_AERIAN;
+    static constexpr int COST_INITIAL = 100;
+    static constexpr double AUTONOMIE = 10;
+    static constexpr int PAS_DAMAGE = 25;
+    static constexpr double PAS_AUTONOMIE = 1;
+    static constexpr Cost costUpgrade(int n) {
+        return 50 * ((Cost)AUTONOMIE + (Cost)PAS_AUTONOMIE * n);
+    }
+};
+
+template <>
+struct CatalogItem<RobotTerestru>{
+    static constexpr TipItem TIP = ROBOT_TERESTRU;
+    static constexpr int COST_INITIAL = 50;
+    static constexpr int NR_GLOANTE = 500;
+    static constexpr int PAS_DAMAGE = 50, PAS_GLOANTE = 100;
+    static constexpr int NIVEL_SCUT = 5, VIATA_SCUT = 50;
+    static constexpr Cost costUpgrade(int n) {
+        return 10 * (NR_GLOANTE + (Cost)PAS_GLOANTE * n);
+    }
+};
+
+// Adevarat daca pe primele `nivele` valori costUpgrade(n) e un polinom de
+// grad cel mult `grad` care nu scade, adica are diferentele finite de
+// ordin 0..grad nenegative si pe cea de ordin grad + 1 zero
+template <typename T>
+constexpr bool costPolinomial(int grad, int nivele) {
+    for(int n = 0 ; n + grad + 1 < nivele ; n++) {
+        Cost diferente[8] = {};
+        for(int j = 0 ; j <= grad + 1 ; j++)
+            diferente[j] = CatalogItem<T>::costUpgrade(n + j);
+        for(int j = 1 ; j <= grad + 1 ; j++)
+            for(int k = grad + 1 ; k >= j ; k--)
+                diferente[k] -= diferente[k - 1];
+        for(int j = 0 ; j <= grad ; j++)
+            if (diferente[j] < 0)
+                return false;
+        if (diferente[grad + 1] != 0)
+            return false;
+    }
+    return true;
+}
+
+// Costurile primelor NIVELE upgrade-uri, calculate la compilare, plus
+// sumele lor partiale: sume[n] = costul primelor n upgrade-uri.
+template <typename T>
+struct TabelCosturi{
+    static constexpr int NIVELE = 64;
+    // Gradul maxim al costului in n; suma de dincolo de tabel foloseste forma inchisa
+    static constexpr int GRAD_MAXIM = 3;
+    static_assert(costPolinomial<T>(GRAD_MAXIM, NIVELE),
+                  "costUpgrade trebuie sa fie un polinom crescator de grad cel mult GRAD_MAXIM");
+    Cost valori[NIVELE];
+    Cost sume[NIVELE + 1];
+
+    constexpr TabelCosturi():valori(),sume() {
+        for(int n = 0 ; n < NIVELE ; n++) {
+            valori[n] = CatalogItem<T>::costUpgrade(n);
+            sume[n + 1] = adunaSaturat(sume[n], valori[n]);
+        }
+    }
+
+    // Un item nu poate trece de INT_MAX upgrade-uri, deci upgrade-ul facut
+    // de la nivelul INT_MAX nu poate fi platit niciodata
+    Cost operator[](long long n) const {
+        if (n < NIVELE)
+            return valori[n];
+        return n < INT_MAX ? CatalogItem<T>::costUpgrade(n) : COST_SATURAT;
+    }
+
+    // Costul upgrade-urilor deLa, deLa + 1, ..., deLa + nivele - 1
+    Cost suma(int deLa, int nivele) const {
+        long long panaLa = (long long)deLa + nivele;
+        if (nivele <= 0)
+            return 0;
+        if (panaLa > INT_MAX)
+            return COST_SATURAT;
+        if (panaLa <= NIVELE && sume[panaLa] != COST_SATURAT)
+            return sume[panaLa] - sume[deLa];
+        if (nivele <= GRAD_MAXIM) {
+            Cost total = 0;
+            for(int n = deLa ; n < panaLa ; n++)
+                total = adunaSaturat(total, (*this)[n]);
+            return total;
+        }
+
+        // Costul e un polinom de grad cel mult GRAD_MAXIM in n, deci suma are
+        // forma inchisa din diferentele finite in deLa:
+        // suma = diferente[0] * C(nivele, 1) + ... + diferente[GRAD_MAXIM] * C(nivele, GRAD_MAXIM + 1)
+        Cost diferente[GRAD_MAXIM + 1];
+        for(int j = 0 ; j <= GRAD_MAXIM ; j++) {
+            diferente[j] = (*this)[deLa + j];
+            // costurile cresc cu n, deci deja ultimul termen nu mai incape
+            if (diferente[j] == COST_SATURAT)
+                return COST_SATURAT;
+        }
+        for(int j = 1 ; j <= GRAD_MAXIM ; j++)
+            for(int k = GRAD_MAXIM ; k >= j ; k--)
+                diferente[k] -= diferente[k - 1];
+        Cost total = 0;
+        for(int j = 0 ; j <= GRAD_MAXIM ; j++)
+            total = adunaSaturat(total, inmultesteSaturat(diferente[j], combinariSaturat(nivele, j + 1)));
+        return total;
+    }
 };
-int Item::counterId = 1;
 
+template <typename T>
+constexpr TabelCosturi<T> TABEL_COSTURI = TabelCosturi<T>();
+
+// Costul urmatorului upgrade pentru n item-uri de acelasi tip:
+// rezultat[i] = costUpgrade(upgradeuri[i]). O bucla simpla peste date
+// contigue, fara apeluri virtuale, pe care compilatorul o poate vectoriza.
+template <typename T>
+void calculeazaCosturi(const int* upgradeuri, Cost* rezultat, int n) {
+    const TabelCosturi<T>& tabel = TABEL_COSTURI<T>;
+    for(int i = 0 ; i < n ; i++)
+        rezultat[i] = tabel[upgradeuri[i]];
+}
+
+// Costul total a cate `nivele` upgrade-uri pentru n item-uri de acelasi tip,
+// tot o bucla peste date contigue
+template <typename T>
+Cost sumeazaCosturi(const int* upgradeuri, int n, int nivele) {
+    const TabelCosturi<T>& tabel = TABEL_COSTURI<T>;
+    Cost total = 0;
+    for(int i = 0 ; i < n ; i++)
+        total = adunaSaturat(total, tabel.suma(upgradeuri[i], nivele));
+    return total;
+}
+
+// Baza pentru tipurile concrete: tipul, costul initial si costurile de
+// upgrade vin din CatalogItem<Derivat>, deci un tip nou nu mai suprascrie
+// getInitialCost / getCostUpgrade / getCostUpgradeDupa.
+template <typename Derivat, typename Baza = Item>
+class ItemCatalogat: public Baza{
+public:
+    ItemCatalogat():Baza(CatalogItem<Derivat>::TIP){}
+    ItemCatalogat(IdRestaurat id):Baza(CatalogItem<Derivat>::TIP, id){}
 
-class Zid: public Item{
+    const int getInitialCost() const {
+        return CatalogItem<Derivat>::COST_INITIAL;
+    }
+    const Cost getCostUpgrade() const {
+        return TABEL_COSTURI<Derivat>[this->upgradeuri];
+    }
+    const Cost getCostUpgradeDupa(int upgradeuri) const {
+        return TABEL_COSTURI<Derivat>[(long long)this->upgradeuri + upgradeuri];
+    }
+    const Cost getCostUpgradeuri(int nivele) const {
+        return TABEL_COSTURI<Derivat>.suma(this->upgradeuri, nivele);
+    }
+};
+
+
+class Zid: public ItemCatalogat<Zid>{
 private:
+    typedef CatalogItem<Zid> Catalog;
+
     double lungime;
     double inaltime;
     double grosime;
 public:
     Zid();
+    explicit Zid(IdRestaurat id);
+
+    void viziteazaCampuri(VizitatorCampuri& v) {
+        v.camp("Lungime", lungime);
+        v.camp("Inaltime", inaltime);
+        v.camp("Grosime", grosime);
+    }
 
     void print(ostream& os) const {
         Item::print(os);
@@ -63,31 +704,36 @@ public:
         zid.print(os);
         return os;
     }
-
-    const int getInitialCost() const {
-        return 300;
-    }
-
-    const int getCostUpgrade() const{
-        return 100 * lungime * inaltime * grosime;
-    }
-    void upgrade() {
-        lungime += 1;
-        inaltime += 1;
-        grosime += 1;
+protected:
+    void aplicaUpgrade(int nivele) {
+        lungime += Catalog::PAS * nivele;
+        inaltime += Catalog::PAS * nivele;
+        grosime += Catalog::PAS * nivele;
     }
 };
-Zid::Zid():Item(){
-   lungime = 1;
-    inaltime = 2;
-   grosime = 0.5;
+Zid::Zid():ItemCatalogat(){
+    lungime = Catalog::LUNGIME;
+    inaltime = Catalog::INALTIME;
+    grosime = Catalog::GROSIME;
+}
+Zid::Zid(IdRestaurat id):ItemCatalogat(id){
+    lungime = Catalog::LUNGIME;
+    inaltime = Catalog::INALTIME;
+    grosime = Catalog::GROSIME;
 }
 
-class Turn: public Item{
+class Turn: public ItemCatalogat<Turn>{
 private:
+    typedef CatalogItem<Turn> Catalog;
+
     double putereLaser;
 public:
     Turn();
+    explicit Turn(IdRestaurat id);
+
+    void viziteazaCampuri(VizitatorCampuri& v) {
+        v.camp("Putere Laser", putereLaser);
+    }
 
     void print(ostream& os) const {
         Item::print(os);
@@ -98,20 +744,16 @@ public:
         turn.print(os);
         return os;
     }
-
-    const int getInitialCost() const {
-        return 500;
-    }
-
-    const int getCostUpgrade() const{
-        return 500 * putereLaser;
-    }
-    void upgrade() {
-        putereLaser += 500;
+protected:
+    void aplicaUpgrade(int nivele) {
+        putereLaser += Catalog::PAS_PUTERE_LASER * nivele;
     }
 };
-Turn::Turn():Item() {
-    putereLaser = 1000;
+Turn::Turn():ItemCatalogat() {
+    putereLaser = Catalog::PUTERE_LASER;
+}
+Turn::Turn(IdRestaurat id):ItemCatalogat(id) {
+    putereLaser = Catalog::PUTERE_LASER;
 }
 
 class Robot: public Item{
@@ -120,7 +762,14 @@ protected:
     int nivel;
     int viata;
 public:
-    Robot();
+    Robot(TipItem tip);
+    Robot(TipItem tip, IdRestaurat id);
+
+    void viziteazaCampuri(VizitatorCampuri& v) {
+        v.camp("Damage", damage);
+        v.camp("Nivel", nivel);
+        v.camp("Viata", viata);
+    }
 
     void print(ostream& os) const {
         Item::print(os);
@@ -132,17 +781,30 @@ public:
         return os;
     }
 };
-Robot::Robot():Item() {
-    nivel = 1;
-    damage = 100;
-    viata = 100;
+Robot::Robot(TipItem tip):Item(tip) {
+    nivel = CatalogRobot::NIVEL;
+    damage = CatalogRobot::DAMAGE;
+    viata = CatalogRobot::VIATA;
+}
+Robot::Robot(TipItem tip, IdRestaurat id):Item(tip, id) {
+    nivel = CatalogRobot::NIVEL;
+    damage = CatalogRobot::DAMAGE;
+    viata = CatalogRobot::VIATA;
 }
 
-class RobotAerian: public Robot{
+class RobotAerian: public ItemCatalogat<RobotAerian, Robot>{
 private:
+    typedef CatalogItem<RobotAerian> Catalog;
+
     double autonomie;
 public:
     RobotAerian();
+    explicit RobotAerian(IdRestaurat id);
+
+    void viziteazaCampuri(VizitatorCampuri& v) {
+        Robot::viziteazaCampuri(v);
+        v.camp("Autonomie", autonomie);
+    }
 
     void print(ostream& os) const {
         Robot::print(os);
@@ -153,30 +815,35 @@ public:
         robot.print(os);
         return os;
     }
-
-    const int getInitialCost() const {
-        return 100;
-    }
-
-    const int getCostUpgrade() const{ 
-        return 50 * autonomie;
-    }
-    void upgrade() {
-        nivel += 1;
-        damage += 25;
-        autonomie += 1;
+protected:
+    void aplicaUpgrade(int nivele) {
+        nivel += nivele;
+        damage += Catalog::PAS_DAMAGE * nivele;
+        autonomie += Catalog::PAS_AUTONOMIE * nivele;
     }
 };
-RobotAerian::RobotAerian():Robot() {
-    autonomie = 10;
+RobotAerian::RobotAerian():ItemCatalogat() {
+    autonomie = Catalog::AUTONOMIE;
+}
+RobotAerian::RobotAerian(IdRestaurat id):ItemCatalogat(id) {
+    autonomie = Catalog::AUTONOMIE;
 }
 
-class RobotTerestru: public Robot{
+class RobotTerestru: public ItemCatalogat<RobotTerestru, Robot>{
 private:
+    typedef CatalogItem<RobotTerestru> Catalog;
+
     int nrGloante;
     bool scut;
 public:
     RobotTerestru();
+    explicit RobotTerestru(IdRestaurat id);
+
+    void viziteazaCampuri(VizitatorCampuri& v) {
+        Robot::viziteazaCampuri(v);
+        v.camp("Nr Gloante", nrGloante);
+        v.camp("Are scut", scut);
+    }
 
     void print(ostream& os) const {
         Robot::print(os);
@@ -187,40 +854,370 @@ public:
         robot.print(os);
         return os;
     }
+protected:
+    void aplicaUpgrade(int nivele) {
+        // Scutul vine o singura data, la upgrade-ul care ajunge la NIVEL_SCUT
+        bool ajungeLaScut = nivel < Catalog::NIVEL_SCUT && nivel + nivele >= Catalog::NIVEL_SCUT;
+        nrGloante += Catalog::PAS_GLOANTE * nivele;
+        nivel += nivele;
+        damage += Catalog::PAS_DAMAGE * nivele;
+        if (ajungeLaScut) {
+            scut = 1;
+            viata += Catalog::VIATA_SCUT;
+        }
+    }
+};
+RobotTerestru::RobotTerestru():ItemCatalogat() {
+    nrGloante = Catalog::NR_GLOANTE;
+    scut = false;
+}
+RobotTerestru::RobotTerestru(IdRestaurat id):ItemCatalogat(id) {
+    nrGloante = Catalog::NR_GLOANTE;
+    scut = false;
+}
 
-    const int getInitialCost() const {
-        return 50;
+// Format snapshot (little-endian, ca pe masina care l-a scris):
+//   "INV" + versiune (1 octet), puncte (int), limita id-urilor (int), nr items (int)
+//   pentru fiecare item: tip (1 octet), id (int), upgrade-uri (int),
+//   campurile in ordinea din viziteazaCampuri (int, double sau bool pe 1 octet)
+const char SNAPSHOT_MAGIC[] = "INV";
+const unsigned char SNAPSHOT_VERSIUNE = 2;
+
+class ScriitorSnapshot: public VizitatorCampuri{
+private:
+    string& buffer;
+
+    template <typename T>
+    void scrieBrut(const T& valoare) {
+        buffer.append(reinterpret_cast<const char*>(&valoare), sizeof(T));
     }
+public:
+    ScriitorSnapshot(string& buffer):buffer(buffer){}
 
-    const int getCostUpgrade() const{
-        return 10 * nrGloante;
+    void scrieOctet(unsigned char valoare) { scrieBrut(valoare); }
+    void scrieInt(int valoare) { scrieBrut(valoare); }
+
+    void camp(const char* nume, int& valoare) { scrieBrut(valoare); }
+    void camp(const char* nume, double& valoare) { scrieBrut(valoare); }
+    void camp(const char* nume, bool& valoare) { scrieOctet(valoare); }
+};
+
+enum FormatExport{
+    TEXT,           // la fel ca operator<<
+    CSV,            // tip,id,valorile campurilor in ordinea din viziteazaCampuri
+    JSON_LINES      // un obiect JSON pe linie
+};
+
+// Formateaza item-uri intr-un buffer, cu to_chars in loc de ostream,
+// ca exportul sa nu aloce nimic dupa ce buffer-ul a crescut o data.
+class FormatatorExport: public VizitatorCampuri{
+private:
+    string& buffer;
+    FormatExport format;
+
+    void adaugaNumar(int valoare) {
+        char text[16];
+        buffer.append(text, to_chars(text, text + sizeof(text), valoare).ptr);
     }
-    void upgrade() {
-        nrGloante += 100;
-        nivel += 1;
-        damage += 50;
-        if (nivel == 5) {
-            scut = 1;
-            viata += 50;
+    void adaugaNumar(long long valoare) {
+        char text[24];
+        buffer.append(text, to_chars(text, text + sizeof(text), valoare).ptr);
+    }
+    void adaugaNumar(double valoare) {
+        // precizia 6 e cea implicita a lui ostream, ca TEXT sa arate la fel
+        char text[32];
+        buffer.append(text, to_chars(text, text + sizeof(text), valoare, chars_format::general, 6).ptr);
+    }
+    template <typename T>
+    void adaugaCamp(const char* nume, T valoare) {
+        switch (format) {
+            case TEXT:
+                buffer += ", ";
+                buffer += nume;
+                buffer += ": ";
+                break;
+            case CSV:
+                buffer += ',';
+                break;
+            case JSON_LINES:
+                buffer += ",\"";
+                buffer += nume;
+                buffer += "\":";
+                break;
+        }
+        adaugaNumar(valoare);
+    }
+public:
+    FormatatorExport(string& buffer, FormatExport format):buffer(buffer),format(format){}
+
+    void item(Item& item) {
+        switch (format) {
+            case TEXT:
+                buffer += "Item ID: ";
+                adaugaNumar(item.getId());
+                break;
+            case CSV:
+                buffer += NUME_TIPURI[item.getTip()];
+                buffer += ',';
+                adaugaNumar(item.getId());
+                break;
+            case JSON_LINES:
+                buffer += "{\"tip\":\"";
+                buffer += NUME_TIPURI[item.getTip()];
+                buffer += "\",\"id\":";
+                adaugaNumar(item.getId());
+                break;
+        }
+        item.viziteazaCampuri(*this);
+        if (format == JSON_LINES)
+            buffer += '}';
+        buffer += '\n';
+    }
+
+    void idSiCost(int id, Cost cost) {
+        adaugaNumar(id);
+        buffer += ' ';
+        adaugaNumar(cost);
+        buffer += '\n';
+    }
+
+    void camp(const char* nume, int& valoare) { adaugaCamp(nume, valoare); }
+    void camp(const char* nume, double& valoare) { adaugaCamp(nume, valoare); }
+    void camp(const char* nume, bool& valoare) {
+        if (format == JSON_LINES) {
+            buffer += ",\"";
+            buffer += nume;
+            buffer += valoare ? "\":true" : "\":false";
+        } else {
+            adaugaCamp(nume, (int)valoare);
         }
     }
 };
-RobotTerestru::RobotTerestru():Robot() {
-    nrGloante = 500;
-    scut = false;
-}
+
+class CititorSnapshot: public VizitatorCampuri{
+private:
+    const char* pozitie;
+    const char* sfarsit;
+
+    template <typename T>
+    T citesteBrut() {
+        if (sfarsit - pozitie < (long)sizeof(T))
+            throw InvalidSnapshotException();
+        T valoare;
+        memcpy(&valoare, pozitie, sizeof(T));
+        pozitie += sizeof(T);
+        return valoare;
+    }
+public:
+    CititorSnapshot(const char* inceput, const char* sfarsit):pozitie(inceput),sfarsit(sfarsit){}
+
+    unsigned char citesteOctet() { return citesteBrut<unsigned char>(); }
+    int citesteInt() { return citesteBrut<int>(); }
+    bool terminat() const { return pozitie == sfarsit; }
+
+    void camp(const char* nume, int& valoare) { valoare = citesteBrut<int>(); }
+    void camp(const char* nume, double& valoare) { valoare = citesteBrut<double>(); }
+    void camp(const char* nume, bool& valoare) { valoare = citesteOctet() != 0; }
+};
+
+// Jurnal binar cu operatiile reusite pe inventar, ca sa le putem relua.
+// Inregistrarile de dimensiune fixa se aduna intr-un buffer si se scriu in
+// fisier cate CAPACITATE o data. Inventarul il apeleaza sub lock-ul lui.
+class JurnalOperatii{
+public:
+    enum Operatie{
+        INCEPUT,        // valoare = punctele de start
+        ADAUGA,         // detaliu = TipItem, valoare = id
+        UPGRADE,        // valoare = id
+        VINDE,          // detaliu = 1 daca s-a pastrat ordinea, valoare = id
+        UPGRADE_TOT,    // valoare = nivele pentru simuleazaUpgradeuri
+        // Item care era deja in inventar cand a inceput inregistrarea (la
+        // seteazaJurnal sau incarca), adaugat fara cost: detaliu = TipItem,
+        // valoare = id. Urmat mereu de NIVELE.
+        EXISTENT,
+        NIVELE          // valoare = upgrade-urile item-ului din EXISTENT
+    };
+    struct Inregistrare{
+        unsigned char operatie;
+        unsigned char detaliu;
+        int valoare;
+    };
+private:
+    static const int CAPACITATE = 4096;
+
+    // Initializat cu zero o singura data, inclusiv octetii de padding din
+    // Inregistrare, care sunt scrisi in fisier dar nu mai sunt atinsi
+    Inregistrare buffer[CAPACITATE];
+    int numar;
+    ofstream out;
+public:
+    JurnalOperatii(const string& fisier):buffer(),numar(0),out(fisier.c_str(), ios::binary){
+        if (!out)
+            throw InvalidJournalException();
+    }
+    ~JurnalOperatii(){ goleste(); }
+
+    void inregistreaza(Operatie operatie, int valoare, unsigned char detaliu = 0) {
+        Inregistrare& inregistrare = buffer[numar++];
+        inregistrare.operatie = operatie;
+        inregistrare.detaliu = detaliu;
+        inregistrare.valoare = valoare;
+        if (numar == CAPACITATE)
+            goleste();
+    }
+
+    void goleste() {
+        out.write(reinterpret_cast<const char*>(buffer), numar * sizeof(Inregistrare));
+        out.flush();
+        numar = 0;
+    }
+};
+
+// Pool pe slab-uri pentru un tip concret de Item. Obiectele sunt construite
+// cu placement new in blocuri de ITEMS_PE_SLAB, iar locurile eliberate sunt
+// refolosite printr-o lista de locuri libere.
+class PoolBaza{
+public:
+    virtual ~PoolBaza(){}
+    virtual void elibereaza(Item* item) = 0;
+};
+
+template <typename T>
+class Pool: public PoolBaza{
+private:
+    static const int ITEMS_PE_SLAB = 1024;
+
+    vector<T*> slaburi;
+    vector<T*> libere;
+    int folositeInUltimulSlab;
+public:
+    Pool():folositeInUltimulSlab(ITEMS_PE_SLAB){}
+
+    // Elibereaza doar memoria, O(#slaburi). Item-urile nu detin resurse,
+    // asa ca nu mai apelam destructorii obiectelor ramase.
+    ~Pool(){
+        for(int i = 0 ; i < slaburi.size() ; i++)
+            ::operator delete(slaburi[i]);
+    }
+
+    template <typename... Args>
+    T* creeaza(Args&&... args) {
+        T* loc;
+        if (!libere.empty()) {
+            loc = libere.back();
+            libere.pop_back();
+        } else {
+            if (folositeInUltimulSlab == ITEMS_PE_SLAB) {
+                slaburi.push_back(static_cast<T*>(::operator new(sizeof(T) * ITEMS_PE_SLAB)));
+                folositeInUltimulSlab = 0;
+            }
+            loc = slaburi.back() + folositeInUltimulSlab++;
+        }
+        return new (loc) T(std::forward<Args>(args)...);
+    }
+
+    void elibereaza(Item* item) {
+        T* obiect = static_cast<T*>(item);
+        obiect->~T();
+        libere.push_back(obiect);
+    }
+};
+
+struct StatisticiReluare{
+    long long operatii;
+    long long esecuri;
+    double secunde;
+    // latente per operatie, in nanosecunde
+    long long p50;
+    long long p99;
+    long long p999;
+};
 
 class Inventar{
+    // Reia si item-urile EXISTENT, prin adaugaExistent
+    friend StatisticiReluare reiaJurnal(const string& fisier, Inventar& inventar);
 private:
     const int PUNCTE_VANZARE = 500;
 
     static Inventar* instance;
     vector<Item*> items;
-    int puncte;
+
+    RegistruPuncte puncte;
+
+    // Protejeaza items si toate indexurile de mai jos. Metodele publice care
+    // doar citesc il iau partajat (shared_lock), deci ruleaza in paralel
+    // intre ele; celelalte il iau exclusiv. Cele private (*FaraBlocare,
+    // cautaPozitie) presupun ca e luat.
+    mutable shared_mutex mtx;
+
+    // Id-ul pentru urmatorul item adaugat. Id-urile sunt date sub lock, din
+    // acest contor, deci raman mici si dense chiar daca item-urile sunt create
+    // pe mai multe thread-uri.
+    int urmatorulId;
+
+    // pozitii[id] = indexul item-ului in items sau -1 daca nu e in inventar.
+    // Id-urile fiind dense, un vector simplu ajunge ca index si cautarea
+    // dupa id devine O(1).
+    vector<int> pozitii;
+
+    // costuri[i] = items[i]->getCostUpgrade(), tinut intr-o coloana separata
+    // si contigua ca sortarea si afisarea sa nu mai faca apeluri virtuale.
+    vector<Cost> costuri;
+
+    // Index sortat persistent dupa (cost upgrade, id). Un upgrade muta doar
+    // intrarea item-ului respectiv, in O(log n), in loc de o sortare completa.
+    set<pair<Cost, int> > ordineCost;
+
+    // Id-urile item-urilor din inventar grupate pe tip; pozitiiInTip[id] e
+    // indexul in lista tipului, ca scoaterea sa fie swap-and-pop in O(1).
+    vector<int> idsPeTip[NR_TIPURI];
+    vector<int> pozitiiInTip;
+
+    // Coloana de upgrade-uri a fiecarui tip, paralela cu idsPeTip:
+    // upgradeuriPeTip[tip][k] = upgrade-urile item-ului idsPeTip[tip][k].
+    // Costurile unui tip se calculeaza din ea cu calculeazaCosturi si
+    // sumeazaCosturi, fara apeluri virtuale si fara sa atingem obiectele.
+    vector<int> upgradeuriPeTip[NR_TIPURI];
+
+    // Daca e setat, operatiile reusite sunt scrise in el
+    JurnalOperatii* jurnal;
+
+    // Refolosit de la un export la altul
+    string bufferExport;
+
+    // Item-urile create cu emplace<T> stau in pool-uri detinute de inventar;
+    // dinPool[id] spune cum trebuie eliberat item-ul cu acel id.
+    map<type_index, PoolBaza*> pooluri;
+    vector<bool> dinPool;
 
     Inventar();
     Inventar(const Inventar&);
     void operator=(const Inventar&);
+
+    void reindexeaza(int deLa = 0);
+    void elibereaza(Item* item);
+    void scoateDinTip(Item* item);
+    int pozitieDupaId(int id) const;
+    int cautaPozitie(int id) const;
+    void verificaIdUnice(const vector<int>& ids) const;
+    CodRezultat adaugaFaraBlocare(Item* item);
+    void inregistreazaItem(Item* item);
+    void golesteFaraBlocare();
+    Item* creeazaRestaurat(unsigned char tip, IdRestaurat id);
+    void scoateFaraBlocare(int id, bool pastreazaOrdinea);
+    void sorteazaFaraBlocare();
+    void upgradeazaTip(int tip, int deLa, int panaLa, int nivele);
+    Cost costUpgradeuriTip(int tip, int deLa, int panaLa, int nivele) const;
+    void jurnalizeazaStareFaraBlocare();
+    const Item* adaugaExistent(unsigned char tip, int upgradeuri);
+
+    template <typename T>
+    Pool<T>& pool() {
+        PoolBaza*& p = pooluri[type_index(typeid(T))];
+        if (p == nullptr)
+            p = new Pool<T>();
+        return *static_cast<Pool<T>*>(p);
+    }
 public:
     ~Inventar();
 
@@ -230,93 +1227,833 @@ public:
     }
 
     // Getters
-    int getPuncte() const { return puncte; }
-    vector<Item*> getItems() const { return items; }
+    int getPuncte() const { return puncte.getSold(); }
+    // Soldul se schimba doar prin operatiile inventarului
+    const RegistruPuncte& getRegistru() const { return puncte; }
+    void activeazaJurnalPuncte(bool activ) { puncte.activeazaJurnal(activ); }
+    // Copie a vectorului; pentru iterare fara copie vezi pentruFiecare
+    vector<const Item*> getItems() const {
+        shared_lock<shared_mutex> blocare(mtx);
+        return vector<const Item*>(items.begin(), items.end());
+    }
+
+    // Apeleaza f(const Item&) pentru fiecare item (sau doar pentru cele de tipul
+    // dat) tinand lock-ul, fara copie. f nu are voie sa apeleze inventarul.
+    template <typename F>
+    void pentruFiecare(F f) const {
+        shared_lock<shared_mutex> blocare(mtx);
+        for(int i = 0 ; i < items.size() ; i++)
+            f(static_cast<const Item&>(*items[i]));
+    }
+    template <typename F>
+    void pentruFiecare(TipItem tip, F f) const {
+        shared_lock<shared_mutex> blocare(mtx);
+        const vector<int>& ids = idsPeTip[tip];
+        for(int i = 0 ; i < ids.size() ; i++)
+            f(static_cast<const Item&>(*items[pozitii[ids[i]]]));
+    }
 
     // 1.
     void adaugaItem(Item* item);
+    template <typename T, typename... Args>
+    T* emplace(Args&&... args);
     void afisareTot();
+    void exporta(ostream& out, FormatExport format = TEXT);
     void afisareCrescatorDupaCostUpgrade();
+    vector<pair<int, Cost> > cheapestUpgrades(int k) const;
+    vector<int> planificaUpgradeuri(long long buget) const;
     void afisareRoboti();
-    Item* gasesteItem(int id);
+    int numara(TipItem tip) const;
+    vector<int> getIdsDupaTip(TipItem tip) const;
+    // Pointerul intors ramane valid doar cat timp nimeni nu vinde item-ul
+    const Item* gasesteItem(int id);
     void upgrade(int id);
+
+    // Aceleasi operatii, dar eroarile comune sunt intoarse ca cod in loc de
+    // exceptie. Variantele de mai sus doar arunca exceptia pentru cod.
+    // tryAdaugaItem nu preia item-ul daca intoarce eroare.
+    CodRezultat tryAdaugaItem(Item* item);
+    CodRezultat tryGasesteItem(int id, const Item*& item);
+    CodRezultat tryUpgrade(int id);
+    CodRezultat tryVinde(int id, bool pastreazaOrdinea = true);
+
+    void upgradeBatch(const vector<int>& ids);
+    void simuleazaUpgradeuri(int nivele, int nrThreaduri);
+    // Cat ar costa simuleazaUpgradeuri(nivele), fara sa schimbe ceva
+    Cost costUpgradeuri(int nivele) const;
     void sorteazaDupaUpgradeCost();
-    void vinde(int id);
+    void vinde(int id, bool pastreazaOrdinea = true);
+    void vindeMultiple(const vector<int>& ids, bool pastreazaOrdinea = true);
+
+    // Snapshot binar cu item-urile, punctele si limita id-urilor.
+    // incarca inlocuieste tot inventarul curent.
+    void salveaza(const string& fisier) const;
+    void incarca(const string& fisier);
+
+    // Goleste inventarul si porneste de la `puncteInitiale`
+    void reseteaza(int puncteInitiale);
+    // Inventarul nu detine jurnalul; nullptr opreste inregistrarea
+    void seteazaJurnal(JurnalOperatii* jurnal);
+
+    // Metricile din Metrici plus numarul de item-uri pe tip
+    void scrieMetrici(const string& fisier) const;
 };
 
+StatisticiReluare reiaJurnal(const string& fisier, Inventar& inventar);
+
 Inventar* Inventar::instance = nullptr;
 
-Inventar::Inventar(){
+Inventar::Inventar():puncte(50000),urmatorulId(1),jurnal(nullptr){
     items = {};
-    puncte = 50000;
 }
 
 Inventar::~Inventar(){
     for(int i = 0 ; i < items.size() ; i++)
-        delete items[i];
+        if (!dinPool[items[i]->getId()])
+            delete items[i];
+    for(map<type_index, PoolBaza*>::iterator it = pooluri.begin() ; it != pooluri.end() ; it++)
+        delete it->second;
 }
 
 void Inventar::adaugaItem(Item *item) {
+    verificaRezultat(tryAdaugaItem(item));
+}
+
+CodRezultat Inventar::tryAdaugaItem(Item *item) {
+    METRICA_OPERATIE(OP_ADAUGA);
+    lock_guard<shared_mutex> blocare(mtx);
+    return adaugaFaraBlocare(item);
+}
+
+CodRezultat Inventar::adaugaFaraBlocare(Item *item) {
 
     int cost = item->getInitialCost();
 
-    if(this->puncte < cost) {
-        throw InsufficientPointsException();
+    // nu mai avem id-uri libere
+    if (urmatorulId == INT_MAX)
+        return ID_INVALID;
+
+    if(!puncte.incearcaCheltuie(cost)) {
+        return PUNCTE_INSUFICIENTE;
     }
 
-    this->puncte -= cost;
+    item->id = urmatorulId++;
+    inregistreazaItem(item);
+    if (jurnal != nullptr)
+        jurnal->inregistreaza(JurnalOperatii::ADAUGA, item->getId(), item->getTip());
+    return OK;
+}
+
+void Inventar::inregistreazaItem(Item *item) {
     this->items.push_back(item);
+    this->costuri.push_back(item->getCostUpgradeCached());
+    this->ordineCost.insert(make_pair(costuri.back(), item->getId()));
+
+    if (item->getId() >= pozitii.size()) {
+        pozitii.resize(item->getId() + 1, -1);
+        dinPool.resize(item->getId() + 1, false);
+        pozitiiInTip.resize(item->getId() + 1, -1);
+    }
+    pozitii[item->getId()] = items.size() - 1;
+
+    vector<int>& ids = idsPeTip[item->getTip()];
+    pozitiiInTip[item->getId()] = ids.size();
+    ids.push_back(item->getId());
+    upgradeuriPeTip[item->getTip()].push_back(item->upgradeuri);
 }
 
-Item* Inventar::gasesteItem(int id) {
-    for(int i = 0 ; i < items.size() ; i++){
-        if(items[i]->getId() == id){
-            return items[i];
-        }
+void Inventar::scoateDinTip(Item* item) {
+    vector<int>& ids = idsPeTip[item->getTip()];
+    vector<int>& upgradeuri = upgradeuriPeTip[item->getTip()];
+    int pozitie = pozitiiInTip[item->getId()];
+    ids[pozitie] = ids.back();
+    upgradeuri[pozitie] = upgradeuri.back();
+    pozitiiInTip[ids[pozitie]] = pozitie;
+    ids.pop_back();
+    upgradeuri.pop_back();
+}
+
+template <typename T, typename... Args>
+T* Inventar::emplace(Args&&... args) {
+    METRICA_OPERATIE(OP_ADAUGA);
+    lock_guard<shared_mutex> blocare(mtx);
+    T* item = pool<T>().creeaza(std::forward<Args>(args)...);
+    CodRezultat cod = adaugaFaraBlocare(item);
+    if (cod != OK) {
+        pool<T>().elibereaza(item);
+        verificaRezultat(cod);
+    }
+    dinPool[item->getId()] = true;
+    return item;
+}
+
+void Inventar::golesteFaraBlocare() {
+    for(int i = 0 ; i < items.size() ; i++) {
+        pozitii[items[i]->getId()] = -1;
+        elibereaza(items[i]);
     }
-    throw InvalidIdException(); 
+    items.clear();
+    costuri.clear();
+    ordineCost.clear();
+    for(int tip = 0 ; tip < NR_TIPURI ; tip++) {
+        idsPeTip[tip].clear();
+        upgradeuriPeTip[tip].clear();
+    }
+}
+
+void Inventar::elibereaza(Item* item) {
+    if (dinPool[item->getId()]) {
+        dinPool[item->getId()] = false;
+        pooluri[type_index(typeid(*item))]->elibereaza(item);
+    } else {
+        delete item;
+    }
+}
+
+void Inventar::reindexeaza(int deLa) {
+    for(int i = deLa ; i < items.size() ; i++)
+        pozitii[items[i]->getId()] = i;
+}
+
+int Inventar::pozitieDupaId(int id) const {
+    if (id < 0 || id >= pozitii.size())
+        return -1;
+    return pozitii[id];
+}
+
+int Inventar::cautaPozitie(int id) const {
+    int pozitie = pozitieDupaId(id);
+    if (pozitie == -1)
+        throw InvalidIdException();
+    return pozitie;
+}
+
+void Inventar::verificaIdUnice(const vector<int>& ids) const {
+    vector<int> sortate = ids;
+    sort(sortate.begin(), sortate.end());
+    if (adjacent_find(sortate.begin(), sortate.end()) != sortate.end())
+        throw InvalidIdException();
+    for(int i = 0 ; i < ids.size() ; i++)
+        cautaPozitie(ids[i]);
+}
+
+const Item* Inventar::gasesteItem(int id) {
+    const Item* item;
+    verificaRezultat(tryGasesteItem(id, item));
+    return item;
+}
+
+CodRezultat Inventar::tryGasesteItem(int id, const Item*& item) {
+    METRICA_OPERATIE(OP_CAUTARE);
+    shared_lock<shared_mutex> blocare(mtx);
+    int pozitie = pozitieDupaId(id);
+    if (pozitie == -1)
+        return ID_INVALID;
+    item = items[pozitie];
+    return OK;
 }
 
 void Inventar::sorteazaDupaUpgradeCost() {
-    sort(this->items.begin(), this->items.end(), [](Item* a, Item* b){
-        return a->getCostUpgrade() < b->getCostUpgrade();
-    });
+    METRICA_OPERATIE(OP_SORTARE);
+    lock_guard<shared_mutex> blocare(mtx);
+    sorteazaFaraBlocare();
+}
+
+void Inventar::sorteazaFaraBlocare() {
+    // Indexul ordineCost e deja sortat, refacem doar ordinea din items in O(n)
+    vector<Item*> itemsSortate;
+    vector<Cost> costuriSortate;
+    itemsSortate.reserve(items.size());
+    costuriSortate.reserve(costuri.size());
+    for(set<pair<Cost, int> >::iterator it = ordineCost.begin() ; it != ordineCost.end() ; it++) {
+        itemsSortate.push_back(items[pozitii[it->second]]);
+        costuriSortate.push_back(it->first);
+    }
+    items.swap(itemsSortate);
+    costuri.swap(costuriSortate);
+    reindexeaza();
 }
 
 void Inventar::afisareCrescatorDupaCostUpgrade() {
-    this->sorteazaDupaUpgradeCost();
+    // Sorteaza si items, ca inainte; cheapestUpgrades e varianta care nu
+    // schimba ordinea din inventar
+    METRICA_OPERATIE(OP_SORTARE);
+    lock_guard<shared_mutex> blocare(mtx);
+    sorteazaFaraBlocare();
+    bufferExport.clear();
+    FormatatorExport formatator(bufferExport, TEXT);
+    for(int i = 0 ; i < items.size() ; i++)
+        formatator.idSiCost(items[i]->getId(), costuri[i]);
+    cout.write(bufferExport.data(), bufferExport.size());
+    cout.flush();
+}
+
+vector<pair<int, Cost> > Inventar::cheapestUpgrades(int k) const {
+    // Primele k intrari din indexul sortat, O(k), fara sa atingem items
+    shared_lock<shared_mutex> blocare(mtx);
+    vector<pair<int, Cost> > rezultat;
+    if (k <= 0)
+        return rezultat;
+    rezultat.reserve(min<size_t>(k, ordineCost.size()));
+    for(set<pair<Cost, int> >::const_iterator it = ordineCost.begin() ; it != ordineCost.end() && rezultat.size() < k ; it++)
+        rezultat.push_back(make_pair(it->second, it->first));
+    return rezultat;
+}
+
+vector<int> Inventar::planificaUpgradeuri(long long buget) const {
+    // Costul fiecarui item creste cu fiecare upgrade, asa ca alegand mereu cel
+    // mai ieftin upgrade urmator obtinem numarul maxim de upgrade-uri in buget.
+    // Costurile urmatoare vin din getCostUpgradeDupa, fara sa simulam obiectele.
+    shared_lock<shared_mutex> blocare(mtx);
+
+    // (cost urmator, (pozitie in items, upgrade-uri deja planificate))
+    typedef pair<Cost, pair<int, int> > Candidat;
+    vector<Candidat> candidati;
+    candidati.reserve(items.size());
     for(int i = 0 ; i < items.size() ; i++)
-        cout << items[i]->getId() << " " << items[i]->getCostUpgrade() << endl;
+        candidati.push_back(make_pair(costuri[i], make_pair(i, 0)));
+    priority_queue<Candidat, vector<Candidat>, greater<Candidat> > heap(greater<Candidat>(), candidati);
+
+    vector<int> plan;
+    while (!heap.empty() && heap.top().first <= buget) {
+        Candidat c = heap.top();
+        heap.pop();
+        buget -= c.first;
+
+        Item* item = items[c.second.first];
+        int upgradeuri = c.second.second + 1;
+        plan.push_back(item->getId());
+        heap.push(make_pair(item->getCostUpgradeDupa(upgradeuri), make_pair(c.second.first, upgradeuri)));
+    }
+    return plan;
 }
 
 void Inventar::afisareTot(){
+    exporta(cout);
+}
+
+void Inventar::exporta(ostream& out, FormatExport format) {
+    // Tot exportul intr-un singur buffer si o singura scriere, fara endl pe fiecare linie
+    lock_guard<shared_mutex> blocare(mtx);
+    bufferExport.clear();
+    FormatatorExport formatator(bufferExport, format);
     for(int i = 0 ; i < items.size(); i++)
-        cout << *items[i] << endl;
+        formatator.item(*items[i]);
+    out.write(bufferExport.data(), bufferExport.size());
+    out.flush();
 }
 
 void Inventar::afisareRoboti() {
-    for(int i = 0; i < items.size(); i++) {
-        if (strcmp(typeid(*items[i]).name(), typeid(RobotAerian).name()) == 0 ||
-            strcmp(typeid(*items[i]).name(), typeid(RobotTerestru).name()) == 0) {
-                cout << typeid(*items[i]).name() << endl;
-            }
-    }
+    // Doar listele tipurilor de roboti, fara typeid/strcmp pe tot inventarul
+    shared_lock<shared_mutex> blocare(mtx);
+    const TipItem roboti[] = {ROBOT_AERIAN, ROBOT_TERESTRU};
+    for(int i = 0 ; i < 2 ; i++)
+        for(int j = 0 ; j < idsPeTip[roboti[i]].size() ; j++)
+            cout << NUME_TIPURI[roboti[i]] << '\n';
+    cout.flush();
+}
+
+int Inventar::numara(TipItem tip) const {
+    shared_lock<shared_mutex> blocare(mtx);
+    return idsPeTip[tip].size();
+}
+
+vector<int> Inventar::getIdsDupaTip(TipItem tip) const {
+    shared_lock<shared_mutex> blocare(mtx);
+    return idsPeTip[tip];
 }
 
 void Inventar::upgrade(int id) {
-    Item* item = gasesteItem(id);
-    int costUpgrade = item->getCostUpgrade();
-    if (this->puncte < costUpgrade) {
+    verificaRezultat(tryUpgrade(id));
+}
+
+CodRezultat Inventar::tryUpgrade(int id) {
+    METRICA_OPERATIE(OP_UPGRADE);
+    lock_guard<shared_mutex> blocare(mtx);
+    int pozitie = pozitieDupaId(id);
+    if (pozitie == -1)
+        return ID_INVALID;
+    Cost costUpgrade = costuri[pozitie];
+    if (!puncte.incearcaCheltuie(costUpgrade)) {
+        return PUNCTE_INSUFICIENTE;
+    }
+    items[pozitie]->upgrade();
+    upgradeuriPeTip[items[pozitie]->getTip()][pozitiiInTip[id]]++;
+    costuri[pozitie] = items[pozitie]->getCostUpgradeCached();
+
+    ordineCost.erase(make_pair(costUpgrade, id));
+    ordineCost.insert(make_pair(costuri[pozitie], id));
+    if (jurnal != nullptr)
+        jurnal->inregistreaza(JurnalOperatii::UPGRADE, id);
+    return OK;
+}
+
+void Inventar::upgradeBatch(const vector<int>& ids) {
+    METRICA_OPERATIE(OP_UPGRADE);
+    lock_guard<shared_mutex> blocare(mtx);
+
+    // Validam tot inainte sa modificam ceva. Fiecare id apare o singura data,
+    // altfel costul celui de-al doilea upgrade ar depinde de primul.
+    verificaIdUnice(ids);
+
+    vector<int> pozitiiBatch(ids.size());
+    for(int i = 0 ; i < ids.size() ; i++)
+        pozitiiBatch[i] = pozitii[ids[i]];
+
+    // Costul total intr-o singura trecere peste coloana costuri
+    Cost costTotal = 0;
+    for(int i = 0 ; i < pozitiiBatch.size() ; i++)
+        costTotal = adunaSaturat(costTotal, costuri[pozitiiBatch[i]]);
+
+    if (!puncte.incearcaCheltuie(costTotal)) {
+        throw InsufficientPointsException();
+    }
+
+    for(int i = 0 ; i < pozitiiBatch.size() ; i++) {
+        int pozitie = pozitiiBatch[i];
+        ordineCost.erase(make_pair(costuri[pozitie], ids[i]));
+        items[pozitie]->upgrade();
+        upgradeuriPeTip[items[pozitie]->getTip()][pozitiiInTip[ids[i]]]++;
+        costuri[pozitie] = items[pozitie]->getCostUpgradeCached();
+        ordineCost.insert(make_pair(costuri[pozitie], ids[i]));
+        if (jurnal != nullptr)
+            jurnal->inregistreaza(JurnalOperatii::UPGRADE, ids[i]);
+    }
+}
+
+void Inventar::simuleazaUpgradeuri(int nivele, int nrThreaduri) {
+    // Fiecare item primeste `nivele` upgrade-uri, cu aceleasi costuri ca
+    // apeluri repetate de upgrade(id), dar totul sau nimic: punctele se
+    // verifica o singura data inainte sa modificam vreun item.
+    lock_guard<shared_mutex> blocare(mtx);
+    if (nivele <= 0 || items.empty())
+        return;
+    // Niciun item nu poate trece de INT_MAX upgrade-uri; refuzam inainte de
+    // faza 1, nu doar prin costul saturat
+    for(int tip = 0 ; tip < NR_TIPURI ; tip++)
+        for(int i = 0 ; i < upgradeuriPeTip[tip].size() ; i++)
+            if (upgradeuriPeTip[tip][i] > INT_MAX - nivele)
+                throw UpgradeOverflowException();
+    nrThreaduri = max(1, min<int>(nrThreaduri, items.size()));
+
+    // Ambele faze merg tip cu tip. Fiecare thread ia felia lui din coloana
+    // fiecarui tip, deci fiecare item e atins de un singur thread
+    vector<thread> threaduri;
+    vector<Cost> costuriPartiale(nrThreaduri, 0);
+
+    // 1. Costul total, din coloanele de upgrade-uri
+    for(int t = 0 ; t < nrThreaduri ; t++)
+        threaduri.push_back(thread([this, t, nrThreaduri, nivele, &costuriPartiale]() {
+            Cost suma = 0;
+            for(int tip = 0 ; tip < NR_TIPURI ; tip++) {
+                int marime = idsPeTip[tip].size();
+                int bucataTip = (marime + nrThreaduri - 1) / nrThreaduri;
+                suma = adunaSaturat(suma, costUpgradeuriTip(tip, min(t * bucataTip, marime), min((t + 1) * bucataTip, marime), nivele));
+            }
+            costuriPartiale[t] = suma;
+        }));
+    for(int t = 0 ; t < nrThreaduri ; t++)
+        threaduri[t].join();
+
+    Cost costTotal = 0;
+    for(int t = 0 ; t < nrThreaduri ; t++)
+        costTotal = adunaSaturat(costTotal, costuriPartiale[t]);
+    if (!puncte.incearcaCheltuie(costTotal)) {
         throw InsufficientPointsException();
     }
-    this->puncte -= costUpgrade;
-    item->upgrade();
+
+    // 2. Upgrade-urile si costurile noi
+    threaduri.clear();
+    for(int t = 0 ; t < nrThreaduri ; t++)
+        threaduri.push_back(thread([this, t, nrThreaduri, nivele]() {
+            for(int tip = 0 ; tip < NR_TIPURI ; tip++) {
+                int marime = idsPeTip[tip].size();
+                int bucataTip = (marime + nrThreaduri - 1) / nrThreaduri;
+                upgradeazaTip(tip, min(t * bucataTip, marime), min((t + 1) * bucataTip, marime), nivele);
+            }
+        }));
+    for(int t = 0 ; t < nrThreaduri ; t++)
+        threaduri[t].join();
+
+    // 3. Indexul sortat, refacut din costurile noi
+    ordineCost.clear();
+    for(int i = 0 ; i < items.size() ; i++)
+        ordineCost.insert(make_pair(costuri[i], items[i]->getId()));
+    if (jurnal != nullptr)
+        jurnal->inregistreaza(JurnalOperatii::UPGRADE_TOT, nivele);
+}
+
+Cost Inventar::costUpgradeuri(int nivele) const {
+    shared_lock<shared_mutex> blocare(mtx);
+    Cost total = 0;
+    for(int tip = 0 ; tip < NR_TIPURI ; tip++)
+        total = adunaSaturat(total, costUpgradeuriTip(tip, 0, idsPeTip[tip].size(), nivele));
+    return total;
+}
+
+Cost Inventar::costUpgradeuriTip(int tip, int deLa, int panaLa, int nivele) const {
+    // Costul a cate `nivele` upgrade-uri pentru item-urile idsPeTip[tip][deLa, panaLa)
+    typedef Cost (*KernelSume)(const int*, int, int);
+    static const KernelSume kernele[NR_TIPURI] = {
+        sumeazaCosturi<Zid>, sumeazaCosturi<Turn>,
+        sumeazaCosturi<RobotAerian>, sumeazaCosturi<RobotTerestru>
+    };
+    if (deLa >= panaLa)
+        return 0;
+    return kernele[tip](upgradeuriPeTip[tip].data() + deLa, panaLa - deLa, nivele);
+}
+
+void Inventar::upgradeazaTip(int tip, int deLa, int panaLa, int nivele) {
+    // Item-urile idsPeTip[tip][deLa, panaLa) primesc toate cele `nivele`
+    // upgrade-uri dintr-un singur apel; costurile noi sunt calculate dintr-o
+    // data din coloana tipului si scrise inapoi in coloana costuri
+    typedef void (*KernelCosturi)(const int*, Cost*, int);
+    static const KernelCosturi kernele[NR_TIPURI] = {
+        calculeazaCosturi<Zid>, calculeazaCosturi<Turn>,
+        calculeazaCosturi<RobotAerian>, calculeazaCosturi<RobotTerestru>
+    };
+    if (deLa >= panaLa)
+        return;
+
+    const vector<int>& ids = idsPeTip[tip];
+    vector<int>& upgradeuri = upgradeuriPeTip[tip];
+    vector<Cost> rezultat(panaLa - deLa);
+    for(int i = deLa ; i < panaLa ; i++) {
+        items[pozitii[ids[i]]]->upgrade(nivele);
+        upgradeuri[i] += nivele;
+    }
+    kernele[tip](upgradeuri.data() + deLa, rezultat.data(), panaLa - deLa);
+    for(int i = deLa ; i < panaLa ; i++)
+        costuri[pozitii[ids[i]]] = rezultat[i - deLa];
+}
+
+void Inventar::vinde(int id, bool pastreazaOrdinea) {
+    verificaRezultat(tryVinde(id, pastreazaOrdinea));
+}
+
+CodRezultat Inventar::tryVinde(int id, bool pastreazaOrdinea) {
+    METRICA_OPERATIE(OP_VINDE);
+    lock_guard<shared_mutex> blocare(mtx);
+    if (pozitieDupaId(id) == -1)
+        return ID_INVALID;
+    if (!puncte.incearcaCrediteaza(this->PUNCTE_VANZARE))
+        return DEPASIRE_PUNCTE;
+    scoateFaraBlocare(id, pastreazaOrdinea);
+    if (jurnal != nullptr)
+        jurnal->inregistreaza(JurnalOperatii::VINDE, id, pastreazaOrdinea);
+    return OK;
+}
+
+void Inventar::scoateFaraBlocare(int id, bool pastreazaOrdinea) {
+    int pozitie = cautaPozitie(id);
+    Item* item = items[pozitie];
+    ordineCost.erase(make_pair(costuri[pozitie], id));
+
+    if (pastreazaOrdinea) {
+        items.erase(items.begin() + pozitie);
+        costuri.erase(costuri.begin() + pozitie);
+        reindexeaza(pozitie);
+    } else {
+        // swap-and-pop: ultimul item ia locul celui vandut, O(1)
+        items[pozitie] = items.back();
+        costuri[pozitie] = costuri.back();
+        pozitii[items[pozitie]->getId()] = pozitie;
+        items.pop_back();
+        costuri.pop_back();
+    }
+
+    pozitii[id] = -1;
+    scoateDinTip(item);
+    elibereaza(item);
+}
+
+void Inventar::vindeMultiple(const vector<int>& ids, bool pastreazaOrdinea) {
+    METRICA_OPERATIE(OP_VINDE);
+    lock_guard<shared_mutex> blocare(mtx);
+
+    // Validam tot inainte sa modificam ceva
+    verificaIdUnice(ids);
+    puncte.crediteaza((long long)this->PUNCTE_VANZARE * ids.size());
+    if (jurnal != nullptr)
+        for(int i = 0 ; i < ids.size() ; i++)
+            jurnal->inregistreaza(JurnalOperatii::VINDE, ids[i], pastreazaOrdinea);
+
+    if (!pastreazaOrdinea) {
+        for(int i = 0 ; i < ids.size() ; i++)
+            scoateFaraBlocare(ids[i], false);
+        return;
+    }
+
+    // Marcam pozitiile vandute cu nullptr si compactam o singura data
+    int primaPozitie = items.size();
+    for(int i = 0 ; i < ids.size() ; i++) {
+        int pozitie = pozitii[ids[i]];
+        primaPozitie = min(primaPozitie, pozitie);
+        ordineCost.erase(make_pair(costuri[pozitie], ids[i]));
+        scoateDinTip(items[pozitie]);
+        elibereaza(items[pozitie]);
+        items[pozitie] = nullptr;
+        pozitii[ids[i]] = -1;
+    }
+    int ramase = primaPozitie;
+    for(int i = primaPozitie ; i < items.size() ; i++) {
+        if (items[i] != nullptr) {
+            items[ramase] = items[i];
+            costuri[ramase] = costuri[i];
+            ramase++;
+        }
+    }
+    items.resize(ramase);
+    costuri.resize(ramase);
+    reindexeaza(primaPozitie);
+}
+
+Item* Inventar::creeazaRestaurat(unsigned char tip, IdRestaurat id) {
+    switch (tip) {
+        case ZID: return pool<Zid>().creeaza(id);
+        case TURN: return pool<Turn>().creeaza(id);
+        case ROBOT_AERIAN: return pool<RobotAerian>().creeaza(id);
+        case ROBOT_TERESTRU: return pool<RobotTerestru>().creeaza(id);
+    }
+    throw InvalidSnapshotException();
+}
+
+void Inventar::salveaza(const string& fisier) const {
+    shared_lock<shared_mutex> blocare(mtx);
+
+    string buffer;
+    ScriitorSnapshot scriitor(buffer);
+    buffer.append(SNAPSHOT_MAGIC, 3);
+    scriitor.scrieOctet(SNAPSHOT_VERSIUNE);
+    scriitor.scrieInt(puncte.getSold());
+    scriitor.scrieInt(urmatorulId);
+    scriitor.scrieInt(items.size());
+    for(int i = 0 ; i < items.size() ; i++) {
+        scriitor.scrieOctet(items[i]->getTip());
+        scriitor.scrieInt(items[i]->getId());
+        scriitor.scrieInt(items[i]->getUpgradeuri());
+        items[i]->viziteazaCampuri(scriitor);
+    }
+
+    ofstream out(fisier.c_str(), ios::binary);
+    out.write(buffer.data(), buffer.size());
+    if (!out)
+        throw InvalidSnapshotException();
+}
+
+void Inventar::incarca(const string& fisier) {
+    // Citim tot fisierul dintr-o data si construim item-urile direct in pool-uri
+    ifstream in(fisier.c_str(), ios::binary | ios::ate);
+    streamoff marime = in.tellg();
+    // marime < 0 daca fisierul nu poate fi parcurs, de ex. un pipe
+    if (!in || marime < 0)
+        throw InvalidSnapshotException();
+    string buffer(marime, '\0');
+    in.seekg(0);
+    in.read(&buffer[0], buffer.size());
+    if (!in)
+        throw InvalidSnapshotException();
+
+    CititorSnapshot cititor(buffer.data(), buffer.data() + buffer.size());
+    char magic[3];
+    for(int i = 0 ; i < 3 ; i++)
+        magic[i] = cititor.citesteOctet();
+    if (memcmp(magic, SNAPSHOT_MAGIC, 3) != 0 || cititor.citesteOctet() != SNAPSHOT_VERSIUNE)
+        throw InvalidSnapshotException();
+    int puncteSalvate = cititor.citesteInt();
+    int counterSalvat = cititor.citesteInt();
+    int nrItems = cititor.citesteInt();
+    if (puncteSalvate < 0 || counterSalvat < 1 || nrItems < 0 || nrItems >= counterSalvat)
+        throw InvalidSnapshotException();
+
+    lock_guard<shared_mutex> blocare(mtx);
+
+    // Construim tot inainte sa atingem inventarul curent
+    vector<Item*> restaurate;
+    restaurate.reserve(nrItems);
+    vector<bool> vazut(counterSalvat, false);
+    try {
+        for(int i = 0 ; i < nrItems ; i++) {
+            unsigned char tip = cititor.citesteOctet();
+            int id = cititor.citesteInt();
+            if (id < 1 || id >= counterSalvat || vazut[id])
+                throw InvalidSnapshotException();
+            vazut[id] = true;
+            restaurate.push_back(creeazaRestaurat(tip, IdRestaurat(id)));
+            restaurate.back()->upgradeuri = cititor.citesteInt();
+            if (restaurate.back()->upgradeuri < 0)
+                throw InvalidSnapshotException();
+            restaurate.back()->viziteazaCampuri(cititor);
+        }
+        if (!cititor.terminat())
+            throw InvalidSnapshotException();
+    } catch (...) {
+        for(int i = 0 ; i < restaurate.size() ; i++)
+            pooluri[type_index(typeid(*restaurate[i]))]->elibereaza(restaurate[i]);
+        throw;
+    }
+
+    golesteFaraBlocare();
+    // Id-urile noi incep dupa cele restaurate
+    urmatorulId = counterSalvat;
+    puncte.seteazaSold(puncteSalvate);
+    pozitii.assign(counterSalvat, -1);
+    dinPool.assign(counterSalvat, false);
+    pozitiiInTip.assign(counterSalvat, -1);
+    items.reserve(nrItems);
+    costuri.reserve(nrItems);
+    for(int i = 0 ; i < restaurate.size() ; i++) {
+        inregistreazaItem(restaurate[i]);
+        dinPool[restaurate[i]->getId()] = true;
+    }
+    if (jurnal != nullptr)
+        jurnalizeazaStareFaraBlocare();
+}
+
+void Inventar::reseteaza(int puncteInitiale) {
+    lock_guard<shared_mutex> blocare(mtx);
+    golesteFaraBlocare();
+    puncte.seteazaSold(puncteInitiale);
+    if (jurnal != nullptr)
+        jurnal->inregistreaza(JurnalOperatii::INCEPUT, puncteInitiale);
+}
+
+void Inventar::seteazaJurnal(JurnalOperatii* jurnal) {
+    lock_guard<shared_mutex> blocare(mtx);
+    this->jurnal = jurnal;
+    if (jurnal != nullptr)
+        jurnalizeazaStareFaraBlocare();
+}
+
+void Inventar::jurnalizeazaStareFaraBlocare() {
+    // Punctele si item-urile de acum, ca reluarea sa porneasca din aceeasi stare
+    jurnal->inregistreaza(JurnalOperatii::INCEPUT, puncte.getSold());
+    for(int i = 0 ; i < items.size() ; i++) {
+        jurnal->inregistreaza(JurnalOperatii::EXISTENT, items[i]->getId(), items[i]->getTip());
+        jurnal->inregistreaza(JurnalOperatii::NIVELE, items[i]->getUpgradeuri());
+    }
+}
+
+const Item* Inventar::adaugaExistent(unsigned char tip, int upgradeuri) {
+    // Item-ul era deja in inventarul inregistrat, deci nu se plateste; primeste
+    // direct upgrade-urile pe care le avea
+    lock_guard<shared_mutex> blocare(mtx);
+    if (tip >= NR_TIPURI || upgradeuri < 0 || urmatorulId == INT_MAX)
+        throw InvalidJournalException();
+    Item* item = creeazaRestaurat(tip, IdRestaurat(urmatorulId));
+    // Un item nu poate avea un upgrade mai scump decat INT_MAX puncte, cat
+    // incape in sold; altfel valoarea din jurnal e corupta
+    if (upgradeuri > 0 && item->getCostUpgradeDupa(upgradeuri - 1) > INT_MAX) {
+        pooluri[type_index(typeid(*item))]->elibereaza(item);
+        throw InvalidJournalException();
+    }
+    urmatorulId++;
+    item->upgrade(upgradeuri);
+    inregistreazaItem(item);
+    dinPool[item->getId()] = true;
+    if (jurnal != nullptr) {
+        jurnal->inregistreaza(JurnalOperatii::EXISTENT, item->getId(), tip);
+        jurnal->inregistreaza(JurnalOperatii::NIVELE, upgradeuri);
+    }
+    return item;
 }
 
-void Inventar::vinde(int id) {
-    Item* item = gasesteItem(id);
-    items.erase(find(items.begin(), items.end(), item));
-    this->puncte += this->PUNCTE_VANZARE;
+StatisticiReluare reiaJurnal(const string& fisier, Inventar& inventar) {
+    ifstream in(fisier.c_str(), ios::binary | ios::ate);
+    streamoff marime = in.tellg();
+    if (!in || marime < 0)
+        throw InvalidJournalException();
+    vector<JurnalOperatii::Inregistrare> inregistrari(marime / sizeof(JurnalOperatii::Inregistrare));
+    in.seekg(0);
+    in.read(reinterpret_cast<char*>(inregistrari.data()), inregistrari.size() * sizeof(JurnalOperatii::Inregistrare));
+    if (!in)
+        throw InvalidJournalException();
+
+    // Id-urile din jurnal nu mai sunt aceleasi in inventarul nou. Un map si
+    // nu un vector indexat dupa id-ul vechi, care e citit din fisier: memoria
+    // creste doar cu item-urile adaugate efectiv in jurnal.
+    unordered_map<int, int> idNou;
+    vector<long long> latente;
+    latente.reserve(inregistrari.size());
+    StatisticiReluare statistici = {0, 0, 0, 0, 0, 0};
+
+    chrono::steady_clock::time_point inceput = chrono::steady_clock::now();
+    for(int i = 0 ; i < inregistrari.size() ; i++) {
+        const JurnalOperatii::Inregistrare& r = inregistrari[i];
+        int idVechi = r.valoare;
+        int id = -1;
+        if (r.operatie == JurnalOperatii::UPGRADE || r.operatie == JurnalOperatii::VINDE) {
+            unordered_map<int, int>::const_iterator it = idNou.find(idVechi);
+            if (it != idNou.end())
+                id = it->second;
+        }
+
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        try {
+            const Item* adaugat = nullptr;
+            switch (r.operatie) {
+                case JurnalOperatii::INCEPUT:
+                    inventar.reseteaza(r.valoare);
+                    break;
+                case JurnalOperatii::ADAUGA:
+                    switch (r.detaliu) {
+                        case ZID: adaugat = inventar.emplace<Zid>(); break;
+                        case TURN: adaugat = inventar.emplace<Turn>(); break;
+                        case ROBOT_AERIAN: adaugat = inventar.emplace<RobotAerian>(); break;
+                        case ROBOT_TERESTRU: adaugat = inventar.emplace<RobotTerestru>(); break;
+                        default: throw InvalidJournalException();
+                    }
+                    break;
+                case JurnalOperatii::EXISTENT:
+                    // Impreuna cu NIVELE-ul de dupa e o singura operatie
+                    if (i + 1 == inregistrari.size() || inregistrari[i + 1].operatie != JurnalOperatii::NIVELE)
+                        throw InvalidJournalException();
+                    i++;
+                    adaugat = inventar.adaugaExistent(r.detaliu, inregistrari[i].valoare);
+                    break;
+                case JurnalOperatii::NIVELE:
+                    throw InvalidJournalException();
+                case JurnalOperatii::UPGRADE:
+                    inventar.upgrade(id);
+                    break;
+                case JurnalOperatii::VINDE:
+                    inventar.vinde(id, r.detaliu != 0);
+                    break;
+                case JurnalOperatii::UPGRADE_TOT:
+                    inventar.simuleazaUpgradeuri(r.valoare, thread::hardware_concurrency());
+                    break;
+                default:
+                    throw InvalidJournalException();
+            }
+            if (adaugat != nullptr)
+                idNou[idVechi] = adaugat->getId();
+        } catch (const std::exception& e) {
+            statistici.esecuri++;
+        }
+        latente.push_back(chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count());
+    }
+    statistici.secunde = chrono::duration<double>(chrono::steady_clock::now() - inceput).count();
+    statistici.operatii = latente.size();
+
+    if (!latente.empty()) {
+        sort(latente.begin(), latente.end());
+        statistici.p50 = latente[latente.size() * 50 / 100];
+        statistici.p99 = latente[latente.size() * 99 / 100];
+        statistici.p999 = latente[latente.size() * 999 / 1000];
+    }
+    return statistici;
+}
+
+void Inventar::scrieMetrici(const string& fisier) const {
+    ofstream out(fisier.c_str());
+    Metrici::getInstance().scrie(out);
+
+    shared_lock<shared_mutex> blocare(mtx);
+    out << "# TYPE inventar_items gauge\n";
+    for(int tip = 0 ; tip < NR_TIPURI ; tip++)
+        out << "inventar_items{tip=\"" << NUME_TIPURI[tip] << "\"} " << idsPeTip[tip].size() << '\n';
+    out << "# TYPE inventar_puncte gauge\n";
+    out << "inventar_puncte " << puncte.getSold() << '\n';
 }
 
 int main(){
@@ -332,13 +2069,123 @@ int main(){
         // }
 
         inventar.adaugaItem(new RobotAerian());
-        inventar.adaugaItem(new RobotTerestru());
-        inventar.adaugaItem(new Zid());
+        inventar.emplace<RobotTerestru>();
+        inventar.emplace<Zid>();
         inventar.adaugaItem(new Turn());
 
         inventar.afisareTot();
         cout << endl;
 
+        // Masurare cautare dupa id in functie de marimea inventarului
+        // (necesita #include <chrono> si destule puncte initiale)
+        // for (int n = 1000; n <= 1000000; n *= 10) {
+        //     while (inventar.getItems().size() < n)
+        //         inventar.adaugaItem(new RobotTerestru());
+        //     int ultimulId = inventar.getItems().back()->getId();
+        //     auto start = chrono::steady_clock::now();
+        //     for (int k = 0; k < 1000000; k++)
+        //         inventar.gasesteItem(ultimulId - k % n);
+        //     auto durata = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start);
+        //     cout << n << " items: " << durata.count() / 1000000.0 << " ns/cautare" << endl;
+        // }
+
+        // Costul a 10 upgrade-uri pentru tot inventarul: un apel virtual prin
+        // vector<Item*> pentru fiecare item vs kernelele pe coloana fiecarui tip
+        // vector<const Item*> copie = inventar.getItems();
+        // auto start = chrono::steady_clock::now();
+        // Cost total = 0;
+        // for (int k = 0; k < copie.size(); k++)
+        //     total = adunaSaturat(total, copie[k]->getCostUpgradeuri(10));
+        // auto mijloc = chrono::steady_clock::now();
+        // Cost totalColoane = inventar.costUpgradeuri(10);
+        // auto final = chrono::steady_clock::now();
+        // cout << "vector<Item*>: " << chrono::duration_cast<chrono::microseconds>(mijloc - start).count() << "us, "
+        //      << "coloane pe tip: " << chrono::duration_cast<chrono::microseconds>(final - mijloc).count() << "us"
+        //      << (total == totalColoane ? "" : ", rezultate diferite!") << endl;
+
+        // Debit upgradeBatch pe loturi de cate 10000 de item-uri
+        // vector<int> lot;
+        // for (int k = 0; k < 10000; k++)
+        //     lot.push_back(inventar.getItems()[k]->getId());
+        // auto start = chrono::steady_clock::now();
+        // inventar.upgradeBatch(lot);
+        // auto durata = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start);
+        // cout << lot.size() * 1000000.0 / durata.count() << " upgrade-uri/s" << endl;
+
+        // Stres cu mai multe thread-uri (necesita #include <thread>)
+        // for (int nrThreaduri = 1; nrThreaduri <= 64; nrThreaduri *= 2) {
+        //     vector<thread> threaduri;
+        //     auto start = chrono::steady_clock::now();
+        //     for (int t = 0; t < nrThreaduri; t++)
+        //         threaduri.push_back(thread([&inventar]() {
+        //             for (int k = 0; k < 1000; k++) {
+        //                 Item* item = inventar.emplace<RobotTerestru>();
+        //                 inventar.vinde(item->getId(), false);
+        //             }
+        //         }));
+        //     for (int t = 0; t < nrThreaduri; t++)
+        //         threaduri[t].join();
+        //     auto durata = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start);
+        //     cout << nrThreaduri << " thread-uri: " << durata.count() << "ms, puncte " << inventar.getPuncte() << endl;
+        // }
+
+        // Latenta pe calea de eroare: exceptie vs cod de rezultat
+        // auto start = chrono::steady_clock::now();
+        // for (int k = 0; k < 100000; k++)
+        //     try { inventar.upgrade(-1); } catch (const InvalidIdException& e) {}
+        // auto mijloc = chrono::steady_clock::now();
+        // for (int k = 0; k < 100000; k++)
+        //     inventar.tryUpgrade(-1);
+        // auto final = chrono::steady_clock::now();
+        // cout << "exceptie: " << chrono::duration_cast<chrono::nanoseconds>(mijloc - start).count() / 100000 << "ns, "
+        //      << "cod: " << chrono::duration_cast<chrono::nanoseconds>(final - mijloc).count() / 100000 << "ns" << endl;
+
+        // Cele mai ieftine 10 upgrade-uri vs sortarea completa a unei copii
+        // auto start = chrono::steady_clock::now();
+        // vector<pair<int, Cost> > ieftine = inventar.cheapestUpgrades(10);
+        // auto mijloc = chrono::steady_clock::now();
+        // vector<const Item*> copie = inventar.getItems();
+        // sort(copie.begin(), copie.end(), [](const Item* a, const Item* b){
+        //     return a->getCostUpgrade() < b->getCostUpgrade();
+        // });
+        // auto final = chrono::steady_clock::now();
+        // cout << "top 10: " << chrono::duration_cast<chrono::microseconds>(mijloc - start).count() << "us, "
+        //      << "sortare: " << chrono::duration_cast<chrono::microseconds>(final - mijloc).count() << "us" << endl;
+
+        // Scalarea simularii de upgrade pe 1..N thread-uri
+        // for (int nrThreaduri = 1; nrThreaduri <= thread::hardware_concurrency(); nrThreaduri *= 2) {
+        //     auto start = chrono::steady_clock::now();
+        //     inventar.simuleazaUpgradeuri(10, nrThreaduri);
+        //     auto durata = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start);
+        //     cout << nrThreaduri << " thread-uri: " << durata.count() << "ms" << endl;
+        // }
+
+        // Cat de multe upgrade-uri putem cumpara cu punctele curente
+        // vector<int> plan = inventar.planificaUpgradeuri(inventar.getPuncte());
+        // for (int k = 0; k < plan.size(); k++)
+        //     inventar.upgrade(plan[k]);
+
+        // Metrici in format Prometheus
+        // inventar.scrieMetrici("inventar.prom");
+
+        // Export pentru loguri
+        // ofstream log("inventar.jsonl");
+        // inventar.exporta(log, JSON_LINES);
+
+        // Inregistrare si reluare de operatii
+        // JurnalOperatii jurnal("operatii.jrn");
+        // inventar.seteazaJurnal(&jurnal);
+        // ... operatii ...
+        // inventar.seteazaJurnal(nullptr);
+        // jurnal.goleste();
+        // StatisticiReluare statistici = reiaJurnal("operatii.jrn", inventar);
+        // cout << statistici.operatii / statistici.secunde << " operatii/s, p50 " << statistici.p50
+        //      << "ns, p99 " << statistici.p99 << "ns, p99.9 " << statistici.p999 << "ns" << endl;
+
+        // Salvare si reincarcare
+        // inventar.salveaza("inventar.bin");
+        // inventar.incarca("inventar.bin");
+
         // infinite money glitch
         // i = 4;
         // while (i++ < 10000) {
@@ -360,6 +2207,10 @@ int main(){
         cout << e.what() << endl;
     }catch(const InvalidIdException& e){
         cout << e.what() << endl;
+    }catch(const InvalidSnapshotException& e){
+        cout << e.what() << endl;
+    }catch(const PointsOverflowException& e){
+        cout << e.what() << endl;
     }catch(...) {
         cout << "eroare" << endl;
     }
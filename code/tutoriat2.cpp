@@ -1,12 +1,14 @@
 #include <iostream>
 #include <string>
+#include "alocator_id.h"
 
 using namespace std;
 
 class Calculator {
     private:
-    static int counter_id;
-    const int id = counter_id;                                               // const int id = counter_id++; Would this work?
+    static int counter_demo;                                                 // Only for functie(), the ids come from Iduri
+    typedef AlocatorId<Calculator> Iduri;                                    // Unique ids even when Calculators are created on many threads
+    const long long id;                                                      // const long long id = Iduri::aloca(); Would this work?
     string procesor;                                                         // How would it affect the initialization list?
     int ram;
     bool placa_video;
@@ -22,35 +24,35 @@ class Calculator {
     // Operators
     Calculator& operator=(const Calculator& obj);               // We return Class& to have a = b = c <=> a = (b = c)
     // Getters
-    int getId()const{return this->id;}                          // Care for the 'const'. We can make it inline
+    long long getId()const{return this->id;}                    // Care for the 'const'. We can make it inline
     // Setters
     // Methods
     // Static Methods
-    static void functie(){                                      // Static Methods only work with static attributes
-        counter_id = 10;                                        // This one has no purpose. Made it inline for simplitude
-        cout<<counter_id;
+    static void functie(){                                      // Static Methods only work with static attributes (and other static methods)
+        counter_demo = 10;                                      // This one has no purpose. Made it inline for simplitude
+        cout<<counter_demo;
     }
 
     ~Calculator(){}                                             // Here we free memory manually allocated, we dont have that yet
 };
  
-int Calculator::counter_id = 1;                                 // Static attributes ARE ALWAYS initialized OUTSIDE the class
+int Calculator::counter_demo = 1;                               // Static attributes ARE ALWAYS initialized OUTSIDE the class
 
-Calculator::Calculator():id(counter_id++){                      // 'const attributes SHOULD be initialized in the INITIALIZATION LIST
+Calculator::Calculator():id(Iduri::aloca()){                    // 'const attributes SHOULD be initialized in the INITIALIZATION LIST
     this->procesor = "unknown";                                 // We can put all the attributes in the list
     this->placa_video = true;                                   // We list them below for readability
     this->ram = 8;                                              // 'this->' is not mandatory
     cout<<"Fara parametri\n";
 }
 
-Calculator::Calculator(string procesor):id(counter_id++){       // We can put anything that we want as a parameter, not necessarily
+Calculator::Calculator(string procesor):id(Iduri::aloca()){     // We can put anything that we want as a parameter, not necessarily
     this->procesor = procesor;                                  // a parameter for each attribute
     this->placa_video = false;
     this->ram = 100000;
     cout<<"Cu parametri\n";
 }
 
-Calculator::Calculator(string procesor, bool placa_video, int ram):id(counter_id++){
+Calculator::Calculator(string procesor, bool placa_video, int ram):id(Iduri::aloca()){
     this->procesor = procesor;                                  // NOTE: Here 'this->' solved the ambiguity between params and attributes
     this->placa_video = placa_video;                            // You can use 'procesor_'  or some other name to differentiate them
     this->ram = ram;                                            // We personally use this convension
@@ -58,7 +60,7 @@ Calculator::Calculator(string procesor, bool placa_video, int ram):id(counter_id
 }                                                               // NOTE: In python we use _function, _attribute to denote that it's private
                                                                 // NOTE: Variables with the prefix '_' or '__' are reserved to the system
 
-Calculator::Calculator(const Calculator& obj):id(counter_id++){
+Calculator::Calculator(const Calculator& obj):id(Iduri::aloca()){
     this->procesor = obj.procesor;
     this->placa_video = obj.placa_video;
     this->ram = obj.ram;
@@ -1,73 +1,136 @@
 #include <iostream>
 #include <cstring>
+#include "alocator_id.h"
+#include <utility>
 
 using namespace std;
 
+#ifdef MASOARA_IDURI                                            // Compile with -DMASOARA_IDURI -pthread to time the ids on many threads
+#include <thread>
+#include <vector>
+#include <chrono>
+#endif
+
+#ifdef NUMARA_ALOCARI                                           // Compile with -DNUMARA_ALOCARI to count every heap allocation
+#include <cstdlib>
+#include <new>
+
+long long alocari = 0;
+
+void* operator new(size_t marime){                              // Replacing the global operator new lets us see every 'new',
+    alocari++;                                                  // including the ones made inside std::string
+    if (void* p = malloc(marime))
+        return p;
+    throw bad_alloc();
+}
+void operator delete(void* p) noexcept{ free(p); }
+void operator delete(void* p, size_t) noexcept{ free(p); }
+#endif
+
 class Calculator {
     private:
-    static int counter_id;
-    const int id = counter_id;                                               
+    static int counter_demo;
+    typedef AlocatorId<Calculator> Iduri;
+    const long long id;                                                      
     string procesor;                                                         
     char* versiune;             // New attribute
     int ram;
     bool placa_video;
+
+    // Short versions ("default", "v1.2") live inside the object, so creating or
+    // copying a Calculator doesn't call 'new' for them. Only longer ones go on the heap.
+    // 'versiune' points either to 'versiuneScurta' or to the heap.
+    static const int LUNGIME_SCURTA = 16;
+    char versiuneScurta[LUNGIME_SCURTA];
+
+    bool versiuneInline()const{return this->versiune == this->versiuneScurta;}
+    void seteazaVersiune(const char* text);
+    void elibereazaVersiune();
+    void mutaVersiune(Calculator& obj);
+
     
     public:
     // Constructors 
     Calculator();
-    Calculator(string procesor, bool placa_video, int ram, char* versiune);
+    Calculator(string procesor, bool placa_video, int ram, const char* versiune);
     Calculator(string procesor);                      
     Calculator(const Calculator& obj);
+    Calculator(Calculator&& obj) noexcept;                     // Move constructor: 'obj' is a temporary, we can steal its memory
     // Operators
     Calculator& operator=(const Calculator& obj);
-    Calculator operator+(const Calculator& obj);
+    Calculator& operator=(Calculator&& obj) noexcept;
+    Calculator operator+(const Calculator& obj) const&;        // a + b: 'a' is a variable, we copy it
+    Calculator operator+(const Calculator& obj) &&;            // (a + b) + c: 'a + b' is a temporary, we add to it directly
     
     // Getters
-    int getId()const{return this->id;}
+    long long getId()const{return this->id;}
     int getRam()const{return this->ram;}
     // Setters
     // Methods
     // Static Methods
     static void functie(){
-        counter_id = 10;
-        cout<<counter_id;
+        counter_demo = 10;
+        cout<<counter_demo;
     }
 
     ~Calculator();
 };
  
-int Calculator::counter_id = 1;
+int Calculator::counter_demo = 1;
+
+void Calculator::seteazaVersiune(const char* text){
+    size_t lungime = strlen(text);
+    if (lungime < LUNGIME_SCURTA)                               // Fits inside the object (+ 1 for '\0'), no 'new' needed
+        this->versiune = this->versiuneScurta;
+    else
+        this->versiune = new char[lungime + 1];                 // Make the pointer 'look' in a new place of the length of the message. + 1 for '\0'
+    memcpy(this->versiune, text, lungime + 1);                  // Copy the message together with its '\0'
+}
 
-Calculator::Calculator():id(counter_id++){   
-    this->versiune = new char[strlen("default") + 1];           // Make the pointer 'look' in a new place of the length of our default message. + 1 for '\0'
-    strcpy(this->versiune, "default");                          // Copy the message 'default' in the new space
+void Calculator::elibereazaVersiune(){
+    if (this->versiune != nullptr && !versiuneInline())        // Only heap memory is deleted, the inline buffer is part of the object
+        delete[] this->versiune;
+    this->versiune = nullptr;
+}
+
+void Calculator::mutaVersiune(Calculator& obj){
+    if (obj.versiuneInline()){                                  // Inline: there is nothing to steal, we copy at most 16 bytes
+        this->versiune = this->versiuneScurta;
+        memcpy(this->versiuneScurta, obj.versiuneScurta, LUNGIME_SCURTA);
+    }
+    else{                                                       // Heap: we take the pointer and 'obj' doesn't own it anymore
+        this->versiune = obj.versiune;
+    }
+    obj.versiune = obj.versiuneScurta;                          // 'obj' stays valid (an empty version) so its destructor is safe
+    obj.versiuneScurta[0] = '\0';
+}
+
+Calculator::Calculator():id(Iduri::aloca()){   
+    seteazaVersiune("default");                                 // 'default' is short, it goes in the inline buffer
 
     this->procesor = "unknown";                                 
     this->placa_video = true;                                  
     this->ram = 8;                                              
 }
 
-Calculator::Calculator(string procesor):id(counter_id++){       
-    this->versiune = new char[strlen("default") + 1];           // Make the pointer 'look' in a new place of the length of our default message. + 1 for '\0'
-    strcpy(this->versiune, "default");                          // Copy the message 'default' in the new space
+Calculator::Calculator(string procesor):id(Iduri::aloca()){       
+    seteazaVersiune("default");
 
     this->procesor = procesor;                                  
     this->placa_video = false;
     this->ram = 100000;
 }
 
-Calculator::Calculator(string procesor, bool placa_video, int ram, char* versiune):id(counter_id++){
-    this->versiune = new char[strlen(versiune) + 1];            // Make the pointer 'look' in a new place of the length of our parameter message. + 1 for '\0'
-    strcpy(this->versiune, versiune);                           // Copy the parameter message in the new space
+Calculator::Calculator(string procesor, bool placa_video, int ram, const char* versiune):id(Iduri::aloca()){
+    seteazaVersiune(versiune);                                  // Inline or on the heap, depending on its length
 
     this->procesor = procesor;                                  
     this->placa_video = placa_video;                            
     this->ram = ram;                                           
 }                                                               
 
-Calculator::Calculator(const Calculator& obj):id(counter_id++){
-    this->versiune = new char[strlen(obj.versiune) + 1];       // Make the pointer 'look' in a new place of the length of the other object's message. + 1 for '\0'
-    strcpy(this->versiune, obj.versiune);                      // Copy the other object's message in the new space
+Calculator::Calculator(const Calculator& obj):id(Iduri::aloca()){
+    seteazaVersiune(obj.versiune);                             // Copy the other object's message in our own space
 
     // this->versiune = obj.versiune;                          // DON'T without a good reason, both the pointers will 'look' at the same memory
                                                                // Deleting from one will affect the other one.
@@ -76,11 +139,15 @@ Calculator::Calculator(const Calculator& obj):id(counter_id++){
     this->ram = obj.ram;
 }
 
+Calculator::Calculator(Calculator&& obj) noexcept:id(Iduri::aloca()){ // A new object, so a new id, just like the copy constructor
+    mutaVersiune(obj);                                         // No 'new' here, the memory of 'obj' becomes ours
+    this->procesor = move(obj.procesor);                       // std::string has its own move
+    this->placa_video = obj.placa_video;
+    this->ram = obj.ram;
+}
+
 Calculator::~Calculator(){
-    if(this->versiune != nullptr){          // Check if it's not pointing at NULL
-        delete[] this->versiune;            // Delete the pointer
-        this->versiune = nullptr;           // Set it back to NULL for safety
-    }
+    elibereazaVersiune();                   // Delete the pointer if it's on the heap and set it back to NULL for safety
 }
 
 Calculator& Calculator::operator=(const Calculator& obj){
@@ -90,13 +157,9 @@ Calculator& Calculator::operator=(const Calculator& obj){
     // this->versiune = obj.versiune;                          // DON'T without a good reason, both the pointers will 'look' at the same memory
                                                                // Deleting from one will affect the other one.
 
-    if (this->versiune != nullptr){                            // Our current object is already allocated so there is a value here so
-        delete[] this->versiune;                               // we safely delete it
-        this->versiune = nullptr;
-    }
-
-    this->versiune = new char[strlen(obj.versiune) + 1];       // Copy the value just like in the copy constructor
-    strcpy(this->versiune, obj.versiune);
+    elibereazaVersiune();                                      // Our current object is already allocated so there is a value here so
+                                                               // we safely delete it
+    seteazaVersiune(obj.versiune);                             // Copy the value just like in the copy constructor
 
     this->procesor = obj.procesor;
     this->placa_video = obj.placa_video;
@@ -104,14 +167,37 @@ Calculator& Calculator::operator=(const Calculator& obj){
     return *this;                                               
 }
 
-Calculator Calculator::operator+(const Calculator& obj){        // The + operator doesn't change the operands
+Calculator& Calculator::operator=(Calculator&& obj) noexcept{
+    if (this == &obj)
+        return *this;
+
+    elibereazaVersiune();                                      // Same as operator=, but we steal instead of copying
+    mutaVersiune(obj);
+
+    this->procesor = move(obj.procesor);
+    this->placa_video = obj.placa_video;
+    this->ram = obj.ram;
+    return *this;
+}
+
+Calculator Calculator::operator+(const Calculator& obj) const&{ // The + operator doesn't change the operands
     Calculator temp = *this;                                    // Make a copy to any of them 
 
     temp.ram += obj.ram;                                        // Apply the changes to any of them
     temp.procesor += obj.procesor;  
                                                                 // NOTE: you can perform any operations here, not only addition
                                                                 //       also you can return any desired type
-    return temp;
+    return temp;                                                // 'temp' is about to die, so it is moved (not copied) out
+}
+
+// In a + b + c + d only a + b makes a copy. Every next + gets that temporary,
+// so it adds to it in place (procesor keeps its memory and grows) and moves it out.
+// The result still gets a new id, like after any move: with std::move(a) + b the
+// left side is 'a', which is still alive and keeps its own id.
+Calculator Calculator::operator+(const Calculator& obj) &&{
+    this->ram += obj.ram;
+    this->procesor += obj.procesor;
+    return move(*this);
 }
 
 int main(){
@@ -121,4 +207,41 @@ int main(){
     cout<< x.getRam() << endl;
     cout <<((x + x) + x).getRam() << endl;
     cout <<(x + (x + x)).getRam() << endl;
+
+    Calculator suma = x + x + x + x;                            // One copy for the whole chain, the partial sums reuse its memory
+    cout << suma.getId() << " " << suma.getRam() << endl;
+
+#ifdef NUMARA_ALOCARI
+    Calculator y("i5");                                         // With the inline version, the move constructor and the in-place sum,
+    long long inainte = alocari;                                // a chained + doesn't allocate anything (before: 2 per expression)
+    for(int i = 0 ; i < 100000 ; i++){
+        Calculator z = (y + y) + y;
+    }
+    cout << "Alocari pentru 100000 x Calculator z = (y + y) + y: " << alocari - inainte << endl;
+
+    inainte = alocari;                                          // "unknownunknownunknown" is too long for std::string's own inline
+    for(int i = 0 ; i < 100000 ; i++){                          // buffer, so the result's procesor allocates once (before: 3 per expression)
+        Calculator z = (x + x) + x;
+    }
+    cout << "Alocari pentru 100000 x Calculator z = (x + x) + x: " << alocari - inainte << endl;
+#endif
+
+#ifdef MASOARA_IDURI
+    atomic<long long> global(1);                                // One shared counter touched for every id, vs the one
+    for(int nrThreaduri = 1 ; nrThreaduri <= 16 ; nrThreaduri *= 2){  // the Calculators use, touched once per 1024 ids
+        for(int varianta = 0 ; varianta < 2 ; varianta++){
+            vector<thread> threaduri;
+            chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            for(int t = 0 ; t < nrThreaduri ; t++)
+                threaduri.push_back(thread([&global, varianta](){
+                    for(int k = 0 ; k < 1000000 ; k++)
+                        varianta == 0 ? global.fetch_add(1) : AlocatorId<Calculator>::aloca();
+                }));
+            for(int t = 0 ; t < nrThreaduri ; t++)
+                threaduri[t].join();
+            long long ms = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start).count();
+            cout << nrThreaduri << " thread-uri, " << (varianta == 0 ? "atomic global: " : "AlocatorId: ") << ms << "ms" << endl;
+        }
+    }
+#endif
 }
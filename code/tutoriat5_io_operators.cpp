@@ -1,27 +1,175 @@
 #include <iostream>
 #include <cstring>
-
+#include "alocator_id.h"
+#include <utility>
+#include <vector>
+#include <string>
+#include <string_view>
+#include <fstream>
+#include <charconv>
+#include <algorithm>
+#include <stdexcept>
+#include <chrono>
+#include <deque>
+#include <unordered_map>
+#include <mutex>
+#include <shared_mutex>
+#include <memory>
+
+#ifdef NUMARA_ALOCARI
+#include <cstdlib>
+#include <new>
+
+// Counts every heap allocation, including the ones inside std::string
+long long alocari = 0;
+
+void* operator new(std::size_t marime){
+    alocari++;
+    if (void* p = std::malloc(marime))
+        return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept{ std::free(p); }
+void operator delete(void* p, std::size_t) noexcept{ std::free(p); }
+#endif
 
 using namespace std;
 
+// Keeps a single copy of every distinct string. In a fleet only a few dozen
+// processors and versions repeat over millions of Calculators, so they all
+// point to the same few strings. The strings stay here until the program ends,
+// so only texts that repeat belong here, i.e. the ones read from input.
+class PoolSiruri {
+private:
+    deque<string> siruri;                           // a deque doesn't move its elements when it grows,
+    unordered_map<string_view, const string*> index;// so the pointers we hand out stay valid
+    const string* gol;
+    mutable shared_mutex mtx;                       // many threads can search at once, only adding is exclusive
+
+    PoolSiruri(){gol = interneaza("");}
+public:
+    PoolSiruri(const PoolSiruri&) = delete;
+    PoolSiruri& operator=(const PoolSiruri&) = delete;
+
+    static PoolSiruri& getInstance(){
+        static PoolSiruri pool;
+        return pool;
+    }
+
+    const string* interneaza(string_view text);
+    const string* getGol()const{return gol;}
+    size_t size()const{
+        shared_lock<shared_mutex> citire(mtx);
+        return siruri.size();
+    }
+};
+
+const string* PoolSiruri::interneaza(string_view text){
+    {
+        shared_lock<shared_mutex> citire(mtx);
+        unordered_map<string_view, const string*>::const_iterator it = index.find(text);
+        if (it != index.end())
+            return it->second;
+    }
+    unique_lock<shared_mutex> scriere(mtx);
+    // another thread may have added it between the two locks
+    unordered_map<string_view, const string*>::const_iterator it = index.find(text);
+    if (it != index.end())
+        return it->second;
+    siruri.emplace_back(text);
+    const string* sir = &siruri.back();
+    index.emplace(string_view(*sir), sir);
+    return sir;
+}
+
+// A handle to a string from PoolSiruri. Copying it copies a pointer, and two
+// pooled handles are equal exactly when they point to the same string.
+// A text the program builds itself, like the processor of a sum, is almost
+// never repeated, so adauga() keeps it out of the pool: the handle owns it
+// and it is freed together with the last handle that uses it.
+class SirInternat {
+private:
+    const string* sir;
+    shared_ptr<string> detinut;                     // empty for texts from the pool
+public:
+    SirInternat():sir(PoolSiruri::getInstance().getGol()){}
+    SirInternat(string_view text):sir(PoolSiruri::getInstance().interneaza(text)){}
+    SirInternat(const string& text):sir(PoolSiruri::getInstance().interneaza(text)){}
+    SirInternat(const char* text):sir(PoolSiruri::getInstance().interneaza(text)){}
+
+    // Moving takes over a text of our own, so it keeps a single owner and
+    // adauga() can still grow it in place; the moved-from handle is left with
+    // the empty string. A pooled text is just pointed to by both.
+    SirInternat(const SirInternat& obj) = default;
+    SirInternat(SirInternat&& obj) noexcept:sir(obj.sir),detinut(move(obj.detinut)){
+        if (detinut != nullptr)
+            obj.sir = PoolSiruri::getInstance().getGol();
+    }
+    SirInternat& operator=(const SirInternat& obj) = default;
+    SirInternat& operator=(SirInternat&& obj) noexcept{
+        if (this != &obj){
+            sir = obj.sir;
+            detinut = move(obj.detinut);
+            if (detinut != nullptr)
+                obj.sir = PoolSiruri::getInstance().getGol();
+        }
+        return *this;
+    }
+
+    const string& str()const{return *sir;}
+    size_t size()const{return sir->size();}
+
+    // Appends 'text'. If nobody else uses our own text it grows in place,
+    // otherwise we start a new one
+    void adauga(const string& text){
+        if (detinut == nullptr || detinut.use_count() != 1){
+            shared_ptr<string> nou = make_shared<string>();
+            nou->reserve(sir->size() + text.size());
+            nou->append(*sir);
+            detinut = nou;
+            sir = nou.get();
+        }
+        detinut->append(text);
+    }
+
+    bool operator==(const SirInternat& obj)const{
+        if (sir == obj.sir)
+            return true;
+        // only a text of our own can be equal to a different string
+        return (detinut != nullptr || obj.detinut != nullptr) && *sir == *obj.sir;
+    }
+    bool operator!=(const SirInternat& obj)const{return !(*this == obj);}
+
+    friend ostream& operator<<(ostream& out, const SirInternat& obj){
+        return out << *obj.sir;
+    }
+};
+
 class Calculator {
 private:
-    static int counter_id;
-    const int id = counter_id;
-    string procesor;
-    char* versiune;             
+    static int counter_demo;
+    typedef AlocatorId<Calculator> Iduri;
+    const long long id;
+    // Read texts come from PoolSiruri, so equal texts are stored once and
+    // copying a Calculator doesn't touch the heap. A sum owns its procesor.
+    SirInternat procesor;
+    SirInternat versiune;
     int ram;
     bool placa_video;
 
+
 public:
     // Constructors
     Calculator();
-    Calculator(string procesor, bool placa_video, int ram, char* versiune);
+    Calculator(string procesor, bool placa_video, int ram, const char* versiune);
     Calculator(string procesor);
     Calculator(const Calculator& obj);
+    Calculator(Calculator&& obj) noexcept;
     // Operators
     Calculator& operator=(const Calculator& obj);
-    Calculator operator+(const Calculator& obj);
+    Calculator& operator=(Calculator&& obj) noexcept;
+    Calculator operator+(const Calculator& obj) const&;        // a + b: 'a' is a variable, we copy it
+    Calculator operator+(const Calculator& obj) &&;            // (a + b) + c: 'a + b' is a temporary, we add to it directly
 
     // For all operators, the 'this' is the lefthand operand
     // in the case of IO operators you COULD write as any other
@@ -34,114 +182,185 @@ public:
     friend ostream& operator<<(ostream& out, const Calculator& obj);
     friend istream& operator>>(istream& in, Calculator& obj);
 
+    // operator>> is meant for a user at the keyboard. For a file with many
+    // records this reads everything at once, without prompts. One record per
+    // line, in the same order operator>> asks for them:
+    //     versiune procesor ram placa_video
+    static vector<Calculator> incarcaFisier(const string& fisier);
+
     // Getters
-    int getId()const{return this->id;}
+    long long getId()const{return this->id;}
     int getRam()const{return this->ram;}
     // Setters
     // Methods
     // Static Methods
     static void functie(){
-        counter_id = 10;
-        cout<<counter_id;
+        counter_demo = 10;
+        cout<<counter_demo;
     }
 
     ~Calculator();
 };
 
-int Calculator::counter_id = 1;
-
-Calculator::Calculator():id(counter_id++){
-    this->versiune = new char[strlen("default") + 1];
-    strcpy(this->versiune, "default");
+int Calculator::counter_demo = 1;
 
+Calculator::Calculator():id(Iduri::aloca()){
+    this->versiune = "default";
     this->procesor = "unknown";
     this->placa_video = true;
     this->ram = 8;
 }
 
-Calculator::Calculator(string procesor):id(counter_id++){
-    this->versiune = new char[strlen("default") + 1];
-    strcpy(this->versiune, "default");
-
+Calculator::Calculator(string procesor):id(Iduri::aloca()){
+    this->versiune = "default";
     this->procesor = procesor;
     this->placa_video = false;
     this->ram = 100000;
 }
 
-Calculator::Calculator(string procesor, bool placa_video, int ram, char* versiune):id(counter_id++){
-    this->versiune = new char[strlen(versiune) + 1];
-    strcpy(this->versiune, versiune);
-
+Calculator::Calculator(string procesor, bool placa_video, int ram, const char* versiune):id(Iduri::aloca()){
+    this->versiune = versiune;
     this->procesor = procesor;
     this->placa_video = placa_video;
     this->ram = ram;
 }
 
-Calculator::Calculator(const Calculator& obj):id(counter_id++){
-    this->versiune = new char[strlen(obj.versiune) + 1];
-    strcpy(this->versiune, obj.versiune);
-
+Calculator::Calculator(const Calculator& obj):id(Iduri::aloca()){
+    this->versiune = obj.versiune;
     this->procesor = obj.procesor;
     this->placa_video = obj.placa_video;
     this->ram = obj.ram;
 }
 
-Calculator::~Calculator(){
+// Pooled texts are only pointed to, so only a sum's own procesor is
+// really stolen
+Calculator::Calculator(Calculator&& obj) noexcept:id(Iduri::aloca()){
+    this->versiune = obj.versiune;
+    this->procesor = move(obj.procesor);
+    this->placa_video = obj.placa_video;
+    this->ram = obj.ram;
+}
 
-    if(this->versiune != nullptr){
-        delete[] this->versiune;
-        this->versiune = nullptr;
-    }
+Calculator::~Calculator(){
+    // nothing to free, the strings belong to PoolSiruri or to the handle
 }
 
 Calculator& Calculator::operator=(const Calculator& obj){
     if (this == &obj)
         return *this;
 
-    if (this->versiune != nullptr){
-        delete[] this->versiune;
-        this->versiune = nullptr;
-    }
+    this->versiune = obj.versiune;
+    this->procesor = obj.procesor;
+    this->placa_video = obj.placa_video;
+    this->ram = obj.ram;
+    return *this;
+}
 
-    this->versiune = new char[strlen(obj.versiune) + 1];
-    strcpy(this->versiune, obj.versiune);
+Calculator& Calculator::operator=(Calculator&& obj) noexcept{
+    if (this == &obj)
+        return *this;
 
-    this->procesor = obj.procesor;
+    this->versiune = obj.versiune;
+    this->procesor = move(obj.procesor);
     this->placa_video = obj.placa_video;
     this->ram = obj.ram;
     return *this;
 }
 
-Calculator Calculator::operator+(const Calculator& obj){
+Calculator Calculator::operator+(const Calculator& obj) const&{
     Calculator temp = *this;
-
     temp.ram += obj.ram;
-    temp.procesor += obj.procesor;
+    temp.procesor.adauga(obj.procesor.str());
     return temp;
 }
 
+// In a + b + c only a + b makes a copy; the next + adds to that temporary and
+// moves it out. The result gets a new id like after any move, since the left
+// side may be std::move(a), which is still alive and keeps its own.
+Calculator Calculator::operator+(const Calculator& obj) &&{
+    this->ram += obj.ram;
+    this->procesor.adauga(obj.procesor.str());
+    return move(*this);
+}
+
 istream& operator>>(istream& in, Calculator &obj){
-    // we must assume the dynamically allocated memory is already there
-    // so we cant just overwrite it
-
-    // 1st we read inside a buffer
-    char versiuneNou[255];
-    cout<<"Versiune: "; in>>versiuneNou;
-    // 2nd we free the already existing memory
-    if(obj.versiune != nullptr)
-        delete[] obj.versiune;
-    // 3rd we copy allocate new space for the char*
-    obj.versiune = new char[strlen(versiuneNou+1)];
-    // 4th we copy the content from the buffer
-    strcpy(obj.versiune, versiuneNou);
+    // we can't read straight into the handles, so
+    // 1st we read inside a buffer (a string, it grows as much as needed)
+    string text;
+    cout<<"Versiune: "; in>>text;
+    // 2nd we keep only the handle from the pool
+    obj.versiune = text;
+    cout<<"Procesor: "; in>>text;
+    obj.procesor = text;
 
     // regular stuff here
-    cout<<"Procesor: ";in>>obj.procesor;
     cout<<"Ram: "; in>>obj.ram;
     cout<<"Placa Video: "; in>>obj.placa_video;
     return in;
 }
 
+// The next word of a line, without copying it. Empty when the line is over.
+static string_view urmatorulCuvant(const char*& p, const char* sfarsit){
+    while (p < sfarsit && (*p == ' ' || *p == '\t' || *p == '\r'))
+        p++;
+    const char* inceput = p;
+    while (p < sfarsit && *p != ' ' && *p != '\t' && *p != '\r')
+        p++;
+    return string_view(inceput, p - inceput);
+}
+
+static bool citesteNumar(string_view cuvant, int& valoare){
+    from_chars_result r = from_chars(cuvant.data(), cuvant.data() + cuvant.size(), valoare);
+    return r.ec == errc() && r.ptr == cuvant.data() + cuvant.size();
+}
+
+vector<Calculator> Calculator::incarcaFisier(const string& fisier){
+    // 1st the whole file in one read
+    ifstream in(fisier, ios::binary);
+    if (!in)
+        throw runtime_error("Nu pot deschide " + fisier);
+    in.seekg(0, ios::end);
+    streamoff marime = in.tellg();
+    if (marime < 0)                                             // e.g. a pipe, we can't jump to its end
+        throw runtime_error("Nu pot afla marimea lui " + fisier);
+    string continut(marime, '\0');
+    in.seekg(0);
+    in.read(&continut[0], continut.size());
+    if (!in)
+        throw runtime_error("Nu pot citi " + fisier);
+
+    // 2nd space for all the records, so the vector never moves them
+    // (moving gives a new id)
+    vector<Calculator> rezultat;
+    rezultat.reserve(count(continut.begin(), continut.end(), '\n') + 1);
+
+    // 3rd every line straight into its Calculator, the words are never copied
+    const char* p = continut.data();
+    const char* sfarsit = p + continut.size();
+    for (int linie = 1 ; p < sfarsit ; linie++){
+        const char* sfarsitLinie = find(p, sfarsit, '\n');
+        string_view cuvinte[5];
+        for (int i = 0 ; i < 5 ; i++)
+            cuvinte[i] = urmatorulCuvant(p, sfarsitLinie);
+        p = sfarsitLinie < sfarsit ? sfarsitLinie + 1 : sfarsit;  // the last line may not end in '\n'
+
+        if (cuvinte[0].empty())                                 // empty line
+            continue;
+        int ram, placaVideo;
+        if (cuvinte[3].empty() || !cuvinte[4].empty() ||
+            !citesteNumar(cuvinte[2], ram) || !citesteNumar(cuvinte[3], placaVideo) ||
+            (placaVideo != 0 && placaVideo != 1))
+            throw runtime_error(fisier + ":" + to_string(linie) + ": inregistrare invalida");
+
+        Calculator& obj = rezultat.emplace_back();
+        obj.versiune = cuvinte[0];
+        obj.procesor = cuvinte[1];
+        obj.ram = ram;
+        obj.placa_video = placaVideo;
+    }
+    return rezultat;
+}
+
 std::ostream& operator<<(ostream& out, const Calculator& obj){
     out << "Id: " << obj.id << '\n';
     out<< "Procesor: " << obj.procesor << '\n';
@@ -154,4 +373,37 @@ std::ostream& operator<<(ostream& out, const Calculator& obj){
 int main(){
     Calculator x;
 
+#ifdef NUMARA_ALOCARI
+    // A chained + builds one Calculator whose procesor grows in place, so each
+    // expression allocates once, for its own text, which is freed with z
+    Calculator y("i5");
+    long long inainte = alocari;
+    for(int i = 0 ; i < 100000 ; i++){
+        Calculator z = (y + y) + y;
+    }
+    cout << "Alocari pentru 100000 x Calculator z = (y + y) + y: " << alocari - inainte << endl;
+
+    // Copies and assignments only copy handles
+    inainte = alocari;
+    for(int i = 0 ; i < 100000 ; i++){
+        Calculator z = y;
+        z = x;
+    }
+    cout << "Alocari pentru 100000 copieri si atribuiri: " << alocari - inainte << endl;
+#endif
+
+#ifdef MASOARA_INCARCARE
+    // Writes 1000000 records and loads them back with incarcaFisier
+    {
+        ofstream out("calculatoare.txt");
+        for(int i = 0 ; i < 1000000 ; i++)
+            out << "v" << i % 50 << " i" << i % 7 << " " << 4 * (i % 16 + 1) << " " << i % 2 << '\n';
+    }
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    vector<Calculator> flota = Calculator::incarcaFisier("calculatoare.txt");
+    chrono::steady_clock::time_point final = chrono::steady_clock::now();
+    double secunde = chrono::duration<double>(final - start).count();
+    cout << flota.size() << " inregistrari in " << secunde << "s, " << flota.size() / secunde << " pe secunda" << endl;
+    cout << PoolSiruri::getInstance().size() << " siruri distincte, " << sizeof(Calculator) << " octeti pe Calculator" << endl;
+#endif
 }